@@ -0,0 +1,603 @@
+/*****************************************************************************************
+/* File: BatchGame.cpp
+/* Description: Runs thousands of independent games on the standard board in lockstep,
+/*				for training and evaluating bots. Each piece of state is stored as one
+/*				array with an entry per game, so every step of a tick is a loop over games
+/*				that the compiler can vectorize (with a hand-written AVX2 collision test
+/*				when built with AVX2 enabled)
+/*
+/* Rachel Pearson 2022
+/*
+/*****************************************************************************************/
+
+#include "BatchGame.h"
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+static_assert(BATCH_SIZE % 8 == 0, "Games are tested 8 at a time");
+
+// --- Rotation states packed for testing 8 games at once ---
+
+// Bounds are stored biased so that each fits in an unsigned byte
+constexpr auto BATCH_BOUNDS_BIAS = 4;
+
+struct BatchShapeTable {
+	int32_t bounds[TET_SHAPE_COUNT * TET_ROTATION_COUNT];	// minX, maxX, minY and maxY, a byte each
+	int32_t rows[TET_SHAPE_COUNT * TET_ROTATION_COUNT];		// Row masks, 4 bits each, top row lowest
+};
+
+/*
+==================
+Packs each rotation state's bounding box and row masks into one
+32-bit value each, indexed by shape * 4 + rotation
+==================
+*/
+constexpr BatchShapeTable BuildBatchShapes() {
+	BatchShapeTable table = {};
+
+	for (int shape = 0; shape < TET_SHAPE_COUNT; shape++) {
+		for (int rotation = 0; rotation < TET_ROTATION_COUNT; rotation++) {
+			const TetrominoState& state = Tetromino::s_states.states[shape][rotation];
+			int index = shape * TET_ROTATION_COUNT + rotation;
+
+			table.bounds[index] = (state.minX + BATCH_BOUNDS_BIAS) |
+								  ((state.maxX + BATCH_BOUNDS_BIAS) << 8) |
+								  ((state.minY + BATCH_BOUNDS_BIAS) << 16) |
+								  ((state.maxY + BATCH_BOUNDS_BIAS) << 24);
+			for (int row = 0; row < TET_TEMPLATE_SIZE; row++) {
+				table.rows[index] |= state.rowMasks[row] << (row * 4);
+			}
+		}
+	}
+	return table;
+}
+
+constexpr BatchShapeTable BATCH_SHAPES = BuildBatchShapes();
+// ----------------------------------------------------------
+
+/*
+==================
+Constructor
+Starts every game, each with its own number as its seed
+
+Parameters:
+>> randomizerType	How the shapes of Tetrominoes are picked
+					(RANDOMIZER_BAG etc.)
+==================
+*/
+BatchGame::BatchGame(int randomizerType) {
+	m_randomizerType = randomizerType;
+
+	for (int game = 0; game < BATCH_SIZE; game++) {
+		Reset(game, (uint64_t)game);
+	}
+}
+
+/*
+==================
+Starts one of the games afresh; it deals the same Tetrominoes
+as a Game created with the same seed
+
+Parameters:
+>> game		Which game to reset (0 to BATCH_SIZE-1)
+>> seed		Seed for the new game's random numbers
+==================
+*/
+void BatchGame::Reset(int game, uint64_t seed) {
+	m_random[game].Seed(seed);
+	m_randomizer[game].Reset(m_randomizerType);
+
+	for (int i = 0; i < HEIGHT; i++) {
+		m_rows[i][game] = 0;
+	}
+	for (int i = 0; i < WIDTH; i++) {
+		m_columns[i][game] = 0;
+	}
+	m_score[game] = 0;
+	m_fallTimer[game] = 0;
+	m_pieceCount[game] = 0;
+	m_gameOver[game] = 0;
+	m_moved[game] = 0;
+	m_lock[game] = 0;
+
+	SpawnTetromino(game);
+}
+
+// ------ Getters & Setters -----
+bool BatchGame::IsGameOver(int game) {
+	return m_gameOver[game] != 0;
+}
+
+int BatchGame::GetScore(int game) {
+	return m_score[game];
+}
+
+int BatchGame::GetPieceCount(int game) {
+	return m_pieceCount[game];
+}
+
+int BatchGame::GetShape(int game) {
+	return m_shape[game];
+}
+
+int BatchGame::GetRotation(int game) {
+	return m_rotation[game];
+}
+
+int BatchGame::GetPivotXTile(int game) {
+	return m_pivotX[game];
+}
+
+int BatchGame::GetPivotYTile(int game) {
+	return m_pivotY[game];
+}
+
+uint32_t BatchGame::GetRowMask(int game, int yTile) {
+	return m_rows[yTile][game];
+}
+// ------------------------------
+
+/*
+==================
+Moves every game on by one tick, in the same order as Game::Tick -
+rotation, then sideways movement, then restarting lock delays,
+then gravity and hard drop, then placing Tetrominoes that have
+landed. Games that are over are left as they are until they are
+reset
+
+Parameters:
+>> inputs	Mask of the INPUT_ bits pressed this tick, for
+			each game
+==================
+*/
+void BatchGame::Step(const uint32_t* inputs) {
+	RotateTetrominoes(inputs, CLOCKWISE);
+	RotateTetrominoes(inputs, ANTICLOCKWISE);
+
+	int count = ListGames(inputs, INPUT_LEFT);
+	SetMoveTests(count, -1);
+	TestCollisions(count);
+	ApplyMoves(count);
+
+	count = ListGames(inputs, INPUT_RIGHT);
+	SetMoveTests(count, 1);
+	TestCollisions(count);
+	ApplyMoves(count);
+
+	ShiftTetrominoes(inputs, INPUT_LEFT_WALL, -1);
+	ShiftTetrominoes(inputs, INPUT_RIGHT_WALL, 1);
+	ResetLockDelays();
+
+	DropTetrominoes(inputs);
+	PlaceTetrominoes();
+}
+
+/*
+==================
+Lists the games that are still running and pressed a given input,
+in m_waiting
+
+Parameters:
+>> inputs		Mask of the INPUT_ bits pressed this tick, for
+				each game
+>> inputBit		The input to look for
+
+Returns:
+>> The number of games listed
+==================
+*/
+int BatchGame::ListGames(const uint32_t* inputs, uint32_t inputBit) {
+	int count = 0;
+
+	for (int game = 0; game < BATCH_SIZE; game++) {
+		m_waiting[count] = game;
+		count += (m_gameOver[game] == 0) & ((inputs[game] & inputBit) != 0);
+	}
+	return count;
+}
+
+/*
+==================
+Sets up a test of moving the player Tetromino of each listed game
+sideways
+
+Parameters:
+>> count	Number of games in m_waiting
+>> dx		Tiles to move right
+==================
+*/
+void BatchGame::SetMoveTests(int count, int dx) {
+	for (int i = 0; i < count; i++) {
+		int game = m_waiting[i];
+		m_testRotation[i] = m_rotation[game];
+		m_testX[i] = m_pivotX[game] + dx;
+		m_testY[i] = m_pivotY[game];
+	}
+}
+
+/*
+==================
+The batched form of TetrominoController::IsColliding - checks the
+position set up for each listed game, writing whether it collides
+to m_hit
+
+Parameters:
+>> count	Number of games in m_waiting
+==================
+*/
+void BatchGame::TestCollisions(int count) {
+	int i = 0;
+
+#ifdef __AVX2__
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i byteMask = _mm256_set1_epi32(0xFF);
+	const __m256i rowMask = _mm256_set1_epi32(0xF);
+	const __m256i bias = _mm256_set1_epi32(BATCH_BOUNDS_BIAS);
+
+	for (; i + 8 <= count; i += 8) {
+		__m256i games = _mm256_loadu_si256((const __m256i*)&m_waiting[i]);
+		__m256i shape = _mm256_i32gather_epi32(m_shape, games, 4);
+		__m256i rotation = _mm256_loadu_si256((const __m256i*)&m_testRotation[i]);
+		__m256i x = _mm256_loadu_si256((const __m256i*)&m_testX[i]);
+		__m256i y = _mm256_loadu_si256((const __m256i*)&m_testY[i]);
+
+		__m256i state = _mm256_add_epi32(_mm256_slli_epi32(shape, 2), rotation);
+		__m256i bounds = _mm256_i32gather_epi32(BATCH_SHAPES.bounds, state, 4);
+		__m256i rows = _mm256_i32gather_epi32(BATCH_SHAPES.rows, state, 4);
+
+		__m256i minX = _mm256_sub_epi32(_mm256_and_si256(bounds, byteMask), bias);
+		__m256i maxX = _mm256_sub_epi32(_mm256_and_si256(_mm256_srli_epi32(bounds, 8), byteMask), bias);
+		__m256i minY = _mm256_sub_epi32(_mm256_and_si256(_mm256_srli_epi32(bounds, 16), byteMask), bias);
+		__m256i maxY = _mm256_sub_epi32(_mm256_srli_epi32(bounds, 24), bias);
+
+		// Walls and floor
+		__m256i left = _mm256_add_epi32(x, minX);
+		__m256i hit = _mm256_cmpgt_epi32(zero, left);
+		hit = _mm256_or_si256(hit, _mm256_cmpgt_epi32(_mm256_add_epi32(x, maxX), _mm256_set1_epi32(WIDTH - 1)));
+		hit = _mm256_or_si256(hit, _mm256_cmpgt_epi32(_mm256_add_epi32(y, maxY), _mm256_set1_epi32(HEIGHT - 1)));
+
+		// Each row of the Tetromino against the board row it covers; rows
+		// off the board are not read
+		__m256i shift = _mm256_max_epi32(left, zero);
+		__m256i top = _mm256_add_epi32(y, minY);
+		for (int row = 0; row < TET_TEMPLATE_SIZE; row++) {
+			__m256i yTile = _mm256_add_epi32(top, _mm256_set1_epi32(row));
+			__m256i onBoard = _mm256_and_si256(_mm256_cmpgt_epi32(yTile, _mm256_set1_epi32(-1)),
+											   _mm256_cmpgt_epi32(_mm256_set1_epi32(HEIGHT), yTile));
+			__m256i index = _mm256_add_epi32(_mm256_mullo_epi32(yTile, _mm256_set1_epi32(BATCH_SIZE)), games);
+			__m256i boardRow = _mm256_mask_i32gather_epi32(zero, (const int*)&m_rows[0][0], index, onBoard, 4);
+
+			__m256i tetRow = _mm256_and_si256(_mm256_srlv_epi32(rows, _mm256_set1_epi32(row * 4)), rowMask);
+			tetRow = _mm256_sllv_epi32(tetRow, shift);
+
+			__m256i overlap = _mm256_cmpeq_epi32(_mm256_and_si256(boardRow, tetRow), zero);
+			hit = _mm256_or_si256(hit, _mm256_xor_si256(overlap, _mm256_set1_epi32(-1)));
+		}
+		_mm256_storeu_si256((__m256i*)&m_hit[i], hit);
+	}
+#endif
+
+	for (; i < count; i++) {
+		m_hit[i] = IsColliding(m_waiting[i], m_testRotation[i], m_testX[i], m_testY[i]);
+	}
+}
+
+/*
+==================
+Checks whether the player Tetromino of one game would collide in a
+given position, as TetrominoController::IsColliding does
+
+Parameters:
+>> game		Which game to test
+>> rotation	Rotation state to test (0 to 3)
+>> xTile	Horizontal tile for the pivot
+>> yTile	Vertical tile for the pivot
+
+Returns:
+>> 1 if the Tetromino would collide there, 0 if it fits
+==================
+*/
+int BatchGame::IsColliding(int game, int rotation, int xTile, int yTile) {
+	const TetrominoState& state = Tetromino::s_states.states[m_shape[game]][rotation];
+	int left = xTile + state.minX;
+	int top = yTile + state.minY;
+
+	// Walls and floor
+	int hit = (left < 0) | (xTile + state.maxX >= WIDTH) | (yTile + state.maxY >= HEIGHT);
+
+	int shift = (left > 0) ? left : 0;
+	for (int row = 0; row < TET_TEMPLATE_SIZE; row++) {
+		int rowTile = top + row;
+		uint32_t boardRow = (rowTile >= 0 && rowTile < HEIGHT) ? m_rows[rowTile][game] : 0;
+		hit |= (boardRow & ((uint32_t)state.rowMasks[row] << shift)) != 0;
+	}
+	return hit;
+}
+
+/*
+==================
+Moves the player Tetromino of each listed game to its tested
+position, where it did not collide, marking it as moved and
+working out its drop distance again, and keeps the games where it
+did collide in the list
+
+Parameters:
+>> count	Number of games in m_waiting
+
+Returns:
+>> The number of games left in the list
+==================
+*/
+int BatchGame::ApplyMoves(int count) {
+	int left = 0;
+
+	for (int i = 0; i < count; i++) {
+		int game = m_waiting[i];
+		if (m_hit[i]) {
+			m_waiting[left++] = game;
+			continue;
+		}
+		m_rotation[game] = m_testRotation[i];
+		m_pivotX[game] = m_testX[i];
+		m_pivotY[game] = m_testY[i];
+		m_dropDistance[game] = GetDropDistance(game);
+		m_moved[game] = 1;
+	}
+	return left;
+}
+
+/*
+==================
+Moves the player Tetromino of each game that pressed a wall shift
+input as far as it will go, a tile at a time. Each pass only tests
+the games that moved on the pass before
+
+Parameters:
+>> inputs		Mask of the INPUT_ bits pressed this tick, for
+				each game
+>> inputBit		INPUT_LEFT_WALL or INPUT_RIGHT_WALL
+>> dx			Direction to move in, -1 or 1
+==================
+*/
+void BatchGame::ShiftTetrominoes(const uint32_t* inputs, uint32_t inputBit, int dx) {
+	int count = ListGames(inputs, inputBit);
+
+	while (count > 0) {
+		SetMoveTests(count, dx);
+		TestCollisions(count);
+
+		int moved = 0;
+		for (int i = 0; i < count; i++) {
+			int game = m_waiting[i];
+			if (m_hit[i] == 0) {
+				m_pivotX[game] = m_testX[i];
+				m_dropDistance[game] = GetDropDistance(game);
+				m_moved[game] = 1;
+				m_waiting[moved++] = game;
+			}
+		}
+		count = moved;
+	}
+}
+
+/*
+==================
+Restarts the lock delay of each game whose resting Tetromino moved
+or rotated this tick, up to MAX_LOCK_RESETS times, as Game::Tick
+does, and clears the moved flags for the next tick
+==================
+*/
+void BatchGame::ResetLockDelays() {
+	for (int game = 0; game < BATCH_SIZE; game++) {
+		RestartLockDelay(m_moved[game] != 0, &m_lockTimer[game], &m_lockResets[game]);
+		m_moved[game] = 0;
+	}
+}
+
+/*
+==================
+Rotates the player Tetromino of every game that pressed the input
+for it, with the same Super Rotation System kicks as
+TetrominoController::RotateTetromino - each kick is tested for all
+of the games still waiting at once
+
+Parameters:
+>> inputs		Mask of the INPUT_ bits pressed this tick, for
+				each game
+>> direction	CLOCKWISE or ANTICLOCKWISE
+==================
+*/
+void BatchGame::RotateTetrominoes(const uint32_t* inputs, int direction) {
+	uint32_t inputBit = (direction == CLOCKWISE) ? INPUT_ROTATE_CW : INPUT_ROTATE_ACW;
+	int count = ListGames(inputs, inputBit);
+
+	for (int kick = 0; kick < SRS_KICK_COUNT && count > 0; kick++) {
+		for (int i = 0; i < count; i++) {
+			int game = m_waiting[i];
+			int dxTile, dyTile;
+			GetKickOffset(m_shape[game], m_rotation[game], direction, kick, &dxTile, &dyTile);
+			m_testRotation[i] = GetRotatedState(m_rotation[game], direction);
+			m_testX[i] = m_pivotX[game] + dxTile;
+			m_testY[i] = m_pivotY[game] + dyTile;
+		}
+		TestCollisions(count);
+		count = ApplyMoves(count);
+	}
+}
+
+/*
+==================
+Moves the player Tetromino of every game down - by gravity, which
+is faster while soft drop is held, or by hard drop - in the same
+way as Game::Tick, and marks the ones to be placed: those hard
+dropped, and those that have rested on the stack for the lock
+delay
+==================
+*/
+void BatchGame::DropTetrominoes(const uint32_t* inputs) {
+	// Gravity and lock delay, for games that are not hard dropping. With the
+	// drop distances known there is nothing to test, so this is one pass of
+	// plain arithmetic over every game, with no branches, that the compiler
+	// vectorizes (8 games at a time with AVX2). Games that are over or hard
+	// dropping work out the same values, and then keep their old ones
+	for (int game = 0; game < BATCH_SIZE; game++) {
+		int running = (m_gameOver[game] == 0) & ((inputs[game] & INPUT_HARD_DROP) == 0);
+		int fallTicks = GetFallTicksForScore(m_score[game], (inputs[game] & INPUT_SOFT_DROP) != 0);
+		int fallTimer = m_fallTimer[game] + 1;
+		int fall = fallTimer >= fallTicks;
+		int drop = fall & (m_dropDistance[game] > 0);
+		int32_t pivotY = m_pivotY[game] + drop;
+		int32_t lockTimer = m_lockTimer[game];
+		int32_t lockResets = m_lockResets[game];
+		int32_t lowestY = m_lowestY[game];
+		int lock = CountLockDelay(pivotY, m_dropDistance[game] == drop, &lockTimer, &lockResets, &lowestY);
+
+		m_fallTimer[game] = running ? (fall ? 0 : fallTimer) : m_fallTimer[game];
+		m_pivotY[game] = running ? pivotY : m_pivotY[game];
+		m_dropDistance[game] -= running & drop;
+		m_lockTimer[game] = running ? lockTimer : m_lockTimer[game];
+		m_lockResets[game] = running ? lockResets : m_lockResets[game];
+		m_lowestY[game] = running ? lowestY : m_lowestY[game];
+		m_lock[game] = running & lock;
+	}
+
+	// Hard drop, straight to where it lands
+	int count = ListGames(inputs, INPUT_HARD_DROP);
+	for (int i = 0; i < count; i++) {
+		int game = m_waiting[i];
+		m_pivotY[game] += m_dropDistance[game];
+		m_dropDistance[game] = 0;
+		m_lock[game] = 1;
+	}
+}
+
+/*
+==================
+The batched form of Board::GetDropDistance - finds how far the
+player Tetromino of one game can fall, from the column masks under
+each of its tiles
+
+Parameters:
+>> game		Which game to drop in
+
+Returns:
+>> The number of rows the Tetromino can move down
+==================
+*/
+int BatchGame::GetDropDistance(int game) {
+	const TetrominoState& state = Tetromino::s_states.states[m_shape[game]][m_rotation[game]];
+	int dropDistance = 0;
+
+	for (int i = 0; i < TET_TILE_COUNT; i++) {
+		int distance = GetColumnDropDistance(m_columns[m_pivotX[game] + state.tileX[i]][game],
+											 m_pivotY[game] + state.tileY[i], HEIGHT);
+		if (i == 0 || distance < dropDistance) {
+			dropDistance = distance;
+		}
+	}
+	return dropDistance;
+}
+
+/*
+==================
+Places the Tetrominoes that have landed, clears any rows they
+filled, and spawns the next Tetrominoes. A Tetromino placed partly
+above the board ends its game, as in Board::PlaceTetromino
+==================
+*/
+void BatchGame::PlaceTetrominoes() {
+	for (int game = 0; game < BATCH_SIZE; game++) {
+		if (m_lock[game] == 0) {
+			continue;
+		}
+		m_lock[game] = 0;
+
+		const TetrominoState& state = Tetromino::s_states.states[m_shape[game]][m_rotation[game]];
+		for (int i = 0; i < TET_TILE_COUNT; i++) {
+			int xTile = m_pivotX[game] + state.tileX[i];
+			int yTile = m_pivotY[game] + state.tileY[i];
+			if (yTile >= 0) {
+				m_rows[yTile][game] |= 1u << xTile;
+				m_columns[xTile][game] |= 1u << yTile;
+			}
+		}
+		if (m_pivotY[game] + state.minY < 0) {
+			m_gameOver[game] = 1;
+			continue;
+		}
+		m_pieceCount[game]++;
+
+		// Only the rows the Tetromino covers can have been filled
+		uint32_t fullRows = 0;
+		for (int yTile = m_pivotY[game] + state.minY; yTile <= m_pivotY[game] + state.maxY; yTile++) {
+			fullRows |= (uint32_t)(m_rows[yTile][game] == FULL_ROW_MASK) << yTile;
+		}
+		if (fullRows != 0) {
+			ClearRows(game, fullRows);
+		}
+		SpawnTetromino(game);
+	}
+}
+
+/*
+==================
+Clears the filled rows of one game, moving the rows above them down
+in a single pass from the bottom up, updates its column masks, and
+adds score as in Game::ClearRows
+
+Parameters:
+>> game			Which game to clear rows in
+>> fullRows		Mask of the filled rows, bit i for row i
+==================
+*/
+void BatchGame::ClearRows(int game, uint32_t fullRows) {
+	int rowsCleared = 0;
+
+	for (int i = HEIGHT - 1; i >= 0; i--) {
+		if ((fullRows >> i) & 1) {
+			rowsCleared++;
+		}
+		else if (rowsCleared > 0) {
+			m_rows[i + rowsCleared][game] = m_rows[i][game];
+		}
+	}
+	for (int i = 0; i < rowsCleared; i++) {
+		m_rows[i][game] = 0;
+	}
+
+	// Take the cleared rows out of each column mask, as Board::ClearFilledRows
+	// does, top row first so that the rows still to go keep their numbers
+	for (uint32_t rows = fullRows; rows != 0; rows &= rows - 1) {
+		int row = CountTrailingZeros(rows);
+		uint32_t above = (1u << row) - 1;
+		for (int i = 0; i < WIDTH; i++) {
+			uint32_t column = m_columns[i][game];
+			m_columns[i][game] = (column & ~(above | (1u << row))) | ((column & above) << 1);
+		}
+	}
+
+	m_score[game] += GetRowClearScore(rowsCleared);
+}
+
+
+/*
+==================
+Spawns the next Tetromino of one game. Its color is drawn and
+thrown away, so that the game's random numbers stay in step with
+a Game's, which deals colors too
+==================
+*/
+void BatchGame::SpawnTetromino(int game) {
+	m_shape[game] = m_randomizer[game].NextShape(&m_random[game]);
+	m_random[game].NextInt(YELLOW - BLUE + 1);
+
+	m_rotation[game] = 0;
+	m_pivotX[game] = (WIDTH - 1) / 2;
+	m_pivotY[game] = TET_START_Y;
+	m_fallTimer[game] = 0;
+	m_lockTimer[game] = 0;
+	m_lockResets[game] = 0;
+	m_lowestY[game] = TET_START_Y;
+	m_dropDistance[game] = GetDropDistance(game);
+}
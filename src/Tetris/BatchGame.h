@@ -0,0 +1,108 @@
+/*****************************************************************************************
+/* File: BatchGame.h
+/* Description: Runs thousands of independent games on the standard board in lockstep,
+/*				for training and evaluating bots. Each piece of state is stored as one
+/*				array with an entry per game, so every step of a tick is a loop over games
+/*				that the compiler can vectorize (with a hand-written AVX2 collision test
+/*				when built with AVX2 enabled)
+/*
+/* Rachel Pearson 2022
+/*
+/*****************************************************************************************/
+
+// ------ Includes -----
+#include <stdint.h>
+#include "Board.h"
+#include "Tetromino.h"
+#include "TetrominoController.h"
+#include "Game.h"
+#include "Random.h"
+#include "Randomizer.h"
+// ---------------------
+
+// ------ Constants -----
+constexpr auto BATCH_SIZE = 4096;		// Games stepped by each call; a multiple of 8
+// ----------------------
+
+#pragma once
+
+// Every game follows the same rules as a Game<StandardBoard> ticked with the same
+// inputs, and a game given the same seed deals the same Tetrominoes. The rules
+// themselves (kicks, gravity, lock delay, scoring and drop distances) come from the
+// shared functions in Game.h, TetrominoController.h and Board.h. Storing and
+// releasing Tetrominoes is not supported, so INPUT_HOLD is ignored. The class is
+// large, so it should be created with new rather than on the stack.
+//
+// In any one tick only a few games press each input, so each step first lists the
+// games it applies to, and then works through that list only
+class BatchGame
+{
+	public:
+		BatchGame(int randomizerType);
+		void Reset(int game, uint64_t seed);
+		void Step(const uint32_t* inputs);
+		bool IsGameOver(int game);
+		int GetScore(int game);
+		int GetPieceCount(int game);
+		int GetShape(int game);
+		int GetRotation(int game);
+		int GetPivotXTile(int game);
+		int GetPivotYTile(int game);
+		uint32_t GetRowMask(int game, int yTile);
+
+	private:
+		static constexpr int WIDTH = StandardBoard::WIDTH;
+		static constexpr int HEIGHT = StandardBoard::HEIGHT;
+		static constexpr uint32_t FULL_ROW_MASK = StandardBoard::FULL_ROW_MASK;
+
+		int m_randomizerType;
+
+		// Board rows, stored row by row with one entry per game, so that a row of
+		// every game can be read in one go
+		uint32_t m_rows[HEIGHT][BATCH_SIZE];
+
+		// Board columns, bit i for row i as in Board, for finding drop distances
+		uint32_t m_columns[WIDTH][BATCH_SIZE];
+
+		// Player Tetromino of each game
+		int32_t m_shape[BATCH_SIZE];
+		int32_t m_rotation[BATCH_SIZE];
+		int32_t m_pivotX[BATCH_SIZE];
+		int32_t m_pivotY[BATCH_SIZE];
+		int32_t m_dropDistance[BATCH_SIZE];		// Rows it can fall; worked out again whenever it moves sideways or rotates
+
+		// Game variables of each game
+		int32_t m_score[BATCH_SIZE];
+		int32_t m_fallTimer[BATCH_SIZE];
+		int32_t m_lockTimer[BATCH_SIZE];
+		int32_t m_lockResets[BATCH_SIZE];
+		int32_t m_lowestY[BATCH_SIZE];
+		int32_t m_pieceCount[BATCH_SIZE];		// Tetrominoes placed, as Game::GetPieceCount
+		int32_t m_gameOver[BATCH_SIZE];
+		Random m_random[BATCH_SIZE];
+		Randomizer m_randomizer[BATCH_SIZE];
+
+		// Working space for a tick - a list of the games waiting on a test, and
+		// the position to test, and the result, for each entry in the list
+		int32_t m_waiting[BATCH_SIZE];
+		int32_t m_testRotation[BATCH_SIZE];
+		int32_t m_testX[BATCH_SIZE];
+		int32_t m_testY[BATCH_SIZE];
+		int32_t m_hit[BATCH_SIZE];			// Non-zero where the tested position collides
+		int32_t m_moved[BATCH_SIZE];		// Per game; set where the Tetromino moved or rotated
+		int32_t m_lock[BATCH_SIZE];			// Per game; set where the Tetromino is to be placed
+
+		int ListGames(const uint32_t* inputs, uint32_t inputBit);
+		void SetMoveTests(int count, int dx);
+		void TestCollisions(int count);
+		int IsColliding(int game, int rotation, int xTile, int yTile);
+		int ApplyMoves(int count);
+		int GetDropDistance(int game);
+		void RotateTetrominoes(const uint32_t* inputs, int direction);
+		void ShiftTetrominoes(const uint32_t* inputs, uint32_t inputBit, int dx);
+		void ResetLockDelays();
+		void DropTetrominoes(const uint32_t* inputs);
+		void PlaceTetrominoes();
+		void ClearRows(int game, uint32_t fullRows);
+		void SpawnTetromino(int game);
+};
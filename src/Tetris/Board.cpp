@@ -1,6 +1,7 @@
 /*****************************************************************************************
 /* File: Board.cpp
-/* Description: Class that stores and manages the state of the board tiles as a 2D array
+/* Description: Class that stores and manages the state of the board tiles as one
+/*				occupancy bitmask per row, plus a separate plane of tile colors
 /*
 /* Rachel Pearson 2022
 /*
@@ -13,7 +14,8 @@
 Constructor
 ==================
 */
-Board::Board() {
+template <int Width, int Height>
+Board<Width, Height>::Board() {
 	InitializeBoard();
 }
 
@@ -22,134 +24,195 @@ Board::Board() {
 Initialise the board by setting all positions to EMPTY
 ==================
 */
-void Board::InitializeBoard() {
-	for (int i = 0; i < BOARD_HEIGHT; i++) {
-		for (int j = 0; j < BOARD_WIDTH; j++) {
-			m_board[i][j] = EMPTY;
-		}
-	}
+template <int Width, int Height>
+void Board<Width, Height>::InitializeBoard() {
+	memset(m_rows, 0, sizeof(m_rows));
+	memset(m_colors, EMPTY, sizeof(m_colors));
+	memset(m_rowCounts, 0, sizeof(m_rowCounts));
+	memset(m_columns, 0, sizeof(m_columns));
+	m_fullRows = 0;
+	m_hash = 0;
 }
 
 // ------ Getters & Setters -----
-int Board::GetTile(int xTile, int yTile)
+template <int Width, int Height>
+int Board<Width, Height>::GetTile(int xTile, int yTile)
 {
-	return m_board[yTile][xTile];
+	return m_colors[yTile][xTile];
 }
-// ------------------------------
 
 /*
 ==================
-Checks whether a given tile in the board is filled
-
-Parameters:
->> xTile	The horizontal tile number (0 to BOARD_WIDTH-1)
->> yTile	The vertical tile number (0 to BOARD_HEIGHT-1)
+Get the number of filled tiles in a given row
+==================
+*/
+template <int Width, int Height>
+int Board<Width, Height>::GetRowCount(int yTile) {
+	return m_rowCounts[yTile];
+}
 
-Returns:
->> True if the tile at that position is filled, false if it
-   is empty or occupied by a Tetromino
+/*
+==================
+Get the height of a given column - the number of rows from the
+bottom of the board up to and including its highest filled tile
 ==================
 */
-bool Board::IsTileFilled(int xTile, int yTile) {
-	if (m_board[yTile][xTile] == EMPTY ||
-		m_board[yTile][xTile] == TET||
-		m_board[yTile][xTile] == TET_PIVOT) {
-		return false;
+template <int Width, int Height>
+int Board<Width, Height>::GetColumnHeight(int xTile) {
+	if (m_columns[xTile] == 0) {
+		return 0;
 	}
-	return true;
+	return Height - CountTrailingZeros(m_columns[xTile]);
+}
+
+/*
+==================
+Get the Zobrist hash of the board - the XOR of the keys of every
+filled tile. It is updated tile by tile as tiles are placed and
+rows are cleared, so this never rehashes the board
+==================
+*/
+template <int Width, int Height>
+uint64_t Board<Width, Height>::GetHash() {
+	return m_hash;
 }
 
 /*
 ==================
-Maps a Tetromino onto the board such that the board
-states are updated with its values
+Finds how far a Tetromino can fall before it lands, straight from
+the column masks - for each tile, the first filled tile below it is
+the lowest set bit of its column mask once the rows above it are
+shifted out. Tiles under an overhang are handled the same way
 
 Parameters:
->> tet		The Tetromino to map
+>> tet		The Tetromino to drop
+
+Returns:
+>> The number of rows the Tetromino can move down
 ==================
 */
-void Board::MapTetromino(Tetromino* tet) {
-	// Upper left tile of template on board
-	int upperLeftX = tet->GetXTile(0);
-	int upperLeftY = tet->GetYTile(0);
-
-	// Map each index of template
-	for (int i = 0; i < TET_TEMPLATE_SIZE; i++) {
-		for (int j = 0; j < TET_TEMPLATE_SIZE; j++) {
-			if (tet->GetTemplate(j, i) != 0 && tet->GetYTile(i) >= 0) {
-				m_board[upperLeftY + i][upperLeftX + j] = tet->GetTemplate(j, i);
-			}
+template <int Width, int Height>
+int Board<Width, Height>::GetDropDistance(Tetromino* tet) {
+	int dropDistance = 0;
+
+	for (int i = 0; i < TET_TILE_COUNT; i++) {
+		int distance = GetColumnDropDistance(m_columns[tet->GetTileX(i)], tet->GetTileY(i), Height);
+		if (i == 0 || distance < dropDistance) {
+			dropDistance = distance;
 		}
 	}
+	return dropDistance;
 }
+// ------------------------------
 
 /*
 ==================
-Clears any Tetromino tiles from the board states
+Checks whether a given tile in the board is filled
+
+Parameters:
+>> xTile	The horizontal tile number (0 to Width-1)
+>> yTile	The vertical tile number (0 to Height-1)
+
+Returns:
+>> True if the tile at that position is filled by a placed
+   Tetromino, false if it is empty
 ==================
 */
-void Board::ClearTetromino() {
-	for (int i = 0; i < BOARD_HEIGHT; i++) {
-		for (int j = 0; j < BOARD_WIDTH; j++) {
-			if (m_board[i][j] == TET || m_board[i][j] == TET_PIVOT) {
-				m_board[i][j] = EMPTY;
-			}
-			
-		}
-	}
+template <int Width, int Height>
+bool Board<Width, Height>::IsTileFilled(int xTile, int yTile) {
+	return (m_rows[yTile] >> xTile) & 1;
 }
 
 /*
 ==================
-Clears a given row from the board
+Get the occupancy mask of a row; bit x is set when tile x of the
+row is filled
 
 Parameters:
->> row		The row to clear
+>> yTile	The vertical tile number (0 to Height-1)
 ==================
 */
-void Board::ClearRow(int row) {
-	for (int i = row; i > 0; i--) {
-		for (int j = 0; j < BOARD_WIDTH; j++) {
-			m_board[i][j] = m_board[i - 1][j];
-		}
-	}
+template <int Width, int Height>
+typename Board<Width, Height>::RowMask Board<Width, Height>::GetRowMask(int yTile) {
+	return m_rows[yTile];
 }
 
 /*
 ==================
-Clears all filled rows that are found in the board
+Clears all filled rows that are found in the board, in a single
+pass from the bottom of the board to the top. Each row that is
+kept is copied at most once, straight to where it ends up
 
 Returns:
->> The number of rows that were cleared
+>> A mask of the rows that were cleared, where bit i is set if
+   row i was cleared (row numbers are from before the clear)
 ==================
 */
-int Board::ClearFilledRows() {
-	int fullRow = true;
-	int rowsCleared = 0;
-
-	// Scan from bottom of board to top
-	for (int i = BOARD_HEIGHT - 1; i > 0; i--) {
-		for (int j = 0; j < BOARD_WIDTH; j++) {
-			if (!IsTileFilled(j, i)) {
-				fullRow = false;
+template <int Width, int Height>
+uint64_t Board<Width, Height>::ClearFilledRows() {
+	uint64_t clearedRows = m_fullRows;
+
+	// Nothing to do unless the last placement filled a row
+	if (clearedRows == 0) {
+		return 0;
+	}
+
+	// Rows below the lowest full row stay where they are
+	int destRow = Height - 1;
+	while (!((clearedRows >> destRow) & 1)) {
+		destRow--;
+	}
+
+	for (int i = destRow; i >= 0; i--) {
+		if ((clearedRows >> i) & 1) {
+			// Hash out the tiles of the cleared row
+			for (uint64_t tiles = m_rows[i]; tiles != 0; tiles &= tiles - 1) {
+				m_hash ^= ZobristTileKey(CountTrailingZeros(tiles), i);
+			}
+		}
+		// Move kept rows down over the cleared ones, moving the hash
+		// of each of their tiles with them
+		else {
+			if (destRow != i) {
+				for (uint64_t tiles = m_rows[i]; tiles != 0; tiles &= tiles - 1) {
+					int xTile = CountTrailingZeros(tiles);
+					m_hash ^= ZobristTileKey(xTile, i) ^ ZobristTileKey(xTile, destRow);
+				}
+				m_rows[destRow] = m_rows[i];
+				m_rowCounts[destRow] = m_rowCounts[i];
+				memcpy(m_colors[destRow], m_colors[i], Width);
 			}
+			destRow--;
 		}
-		if (fullRow) {
-			ClearRow(i);
-			// Put 'i' back if we cleared a row, because everything
-			// has shifted down now
-			i++;
-			rowsCleared++;
+	}
+
+	// Empty the rows left at the top
+	for (int i = destRow; i >= 0; i--) {
+		m_rows[i] = 0;
+		m_rowCounts[i] = 0;
+		memset(m_colors[i], EMPTY, Width);
+	}
+
+	// Remove the cleared rows from each column mask, top row first so
+	// that the rows still to be removed keep their numbers
+	for (uint64_t rows = clearedRows; rows != 0; rows &= rows - 1) {
+		int row = CountTrailingZeros(rows);
+		uint64_t above = (1ull << row) - 1;
+		for (int i = 0; i < Width; i++) {
+			m_columns[i] = (m_columns[i] & ~(above | (1ull << row))) | ((m_columns[i] & above) << 1);
 		}
-		fullRow = true;
 	}
-	return rowsCleared;
+
+	m_fullRows = 0;
+	return clearedRows;
 }
 
 /*
 ==================
-Places the current Tetromino onto the board by converting
-any Tetromino tiles to standard filled board tiles
+Places the current Tetromino onto the board by setting the bit
+of each of its tiles in their row masks, and giving those tiles
+its color. Row counts, column masks, the mask of full rows and
+the hash are updated for just the tiles placed
 
 Parameters:
 >> tet		The Tetromino to place
@@ -160,12 +223,23 @@ Returns:
 
 ==================
 */
-bool Board::PlaceTetromino(Tetromino* tet) {
-	for (int i = 0; i < BOARD_HEIGHT; i++) {
-		for (int j = 0; j < BOARD_WIDTH; j++) {
-			if (GetTile(j, i) == TET || GetTile(j, i) == TET_PIVOT) {
-				m_board[i][j] = tet->GetColor();
+template <int Width, int Height>
+bool Board<Width, Height>::PlaceTetromino(Tetromino* tet) {
+	for (int i = 0; i < TET_TILE_COUNT; i++) {
+		int xTile = tet->GetTileX(i);
+		int yTile = tet->GetTileY(i);
+
+		// Tiles above the board are not placed
+		if (yTile >= 0) {
+			m_rows[yTile] |= (RowMask)1 << xTile;
+			m_colors[yTile][xTile] = tet->GetColor();
+
+			m_rowCounts[yTile]++;
+			if (m_rowCounts[yTile] == Width) {
+				m_fullRows |= 1ull << yTile;
 			}
+			m_columns[xTile] |= 1ull << yTile;
+			m_hash ^= ZobristTileKey(xTile, yTile);
 		}
 	}
 	if (IsTetrominoAboveBoard(tet)) {
@@ -174,6 +248,113 @@ bool Board::PlaceTetromino(Tetromino* tet) {
 	return true;
 }
 
+/*
+==================
+Finds the rows that placing a Tetromino (and clearing any rows it
+fills) can change, so that the placement can be undone. These run
+from the higher of the top of the stack and the Tetromino's top
+tile down to its bottom tile; rows above are empty before and
+after, and rows below are never touched
+
+Parameters:
+>> tet		The Tetromino about to be placed
+
+Returns:
+>> The record to pass to SaveRows, and later RestoreRows
+==================
+*/
+template <int Width, int Height>
+typename Board<Width, Height>::UndoRecord Board<Width, Height>::GetUndoRecord(Tetromino* tet) {
+	uint64_t filledRows = 0;
+	for (int i = 0; i < Width; i++) {
+		filledRows |= m_columns[i];
+	}
+
+	int firstRow = (filledRows != 0) ? CountTrailingZeros(filledRows) : Height;
+	int lastRow = -1;
+	for (int i = 0; i < TET_TILE_COUNT; i++) {
+		if (tet->GetTileY(i) < firstRow) {
+			firstRow = tet->GetTileY(i);
+		}
+		if (tet->GetTileY(i) > lastRow) {
+			lastRow = tet->GetTileY(i);
+		}
+	}
+	if (firstRow < 0) {
+		firstRow = 0;
+	}
+
+	UndoRecord record;
+	record.firstRow = firstRow;
+	record.lastRow = lastRow;
+	record.fullRows = m_fullRows;
+	record.hash = m_hash;
+	return record;
+}
+
+/*
+==================
+Saves the rows of an undo record - their masks, then their counts,
+then their colors
+
+Parameters:
+>> record	From GetUndoRecord
+>> rowData	Where to save the rows; UNDO_ROW_SIZE bytes for each
+			row of the record
+==================
+*/
+template <int Width, int Height>
+void Board<Width, Height>::SaveRows(const UndoRecord& record, uint8_t* rowData) {
+	if (record.firstRow > record.lastRow) {
+		return;
+	}
+	int rowCount = record.lastRow - record.firstRow + 1;
+	memcpy(rowData, &m_rows[record.firstRow], rowCount * sizeof(RowMask));
+	rowData += rowCount * sizeof(RowMask);
+	memcpy(rowData, &m_rowCounts[record.firstRow], rowCount);
+	rowData += rowCount;
+	memcpy(rowData, m_colors[record.firstRow], rowCount * Width);
+}
+
+/*
+==================
+Puts back the rows saved by SaveRows, undoing a placement. The
+column masks are rebuilt for just those rows
+
+Parameters:
+>> record	From GetUndoRecord
+>> rowData	The rows saved by SaveRows
+==================
+*/
+template <int Width, int Height>
+void Board<Width, Height>::RestoreRows(const UndoRecord& record, const uint8_t* rowData) {
+	int firstRow = record.firstRow;
+	int lastRow = record.lastRow;
+
+	if (firstRow <= lastRow) {
+		int rowCount = lastRow - firstRow + 1;
+		memcpy(&m_rows[firstRow], rowData, rowCount * sizeof(RowMask));
+		rowData += rowCount * sizeof(RowMask);
+		memcpy(&m_rowCounts[firstRow], rowData, rowCount);
+		rowData += rowCount;
+		memcpy(m_colors[firstRow], rowData, rowCount * Width);
+
+		// Mask of the restored rows within a column
+		uint64_t restoredRows = ((lastRow == 63) ? ~0ull : (1ull << (lastRow + 1)) - 1) &
+								~((1ull << firstRow) - 1);
+		for (int i = 0; i < Width; i++) {
+			m_columns[i] &= ~restoredRows;
+		}
+		for (int i = firstRow; i <= lastRow; i++) {
+			for (uint64_t tiles = m_rows[i]; tiles != 0; tiles &= tiles - 1) {
+				m_columns[CountTrailingZeros(tiles)] |= 1ull << i;
+			}
+		}
+	}
+	m_fullRows = record.fullRows;
+	m_hash = record.hash;
+}
+
 /*
 ==================
 Checks if any part of a given tetromino is above the board
@@ -187,16 +368,12 @@ Returns:
 
 ==================
 */
-bool Board::IsTetrominoAboveBoard(Tetromino* tet) {
-	// Check each index of template
-	for (int i = 0; i < TET_TEMPLATE_SIZE; i++) {
-		for (int j = 0; j < TET_TEMPLATE_SIZE; j++) {
-			if (tet->GetTemplate(i, j) == TET ||
-				tet->GetTemplate(j, i) == TET_PIVOT) {
-				if (tet->GetYTile(i) < 0) {
-					return true;
-				}
-			}
+template <int Width, int Height>
+bool Board<Width, Height>::IsTetrominoAboveBoard(Tetromino* tet) {
+	// Check each tile of the Tetromino
+	for (int i = 0; i < TET_TILE_COUNT; i++) {
+		if (tet->GetTileY(i) < 0) {
+			return true;
 		}
 	}
 	return false;
@@ -207,11 +384,14 @@ bool Board::IsTetrominoAboveBoard(Tetromino* tet) {
 Resets the board to its initial empty state
 ==================
 */
-void Board::Reset() {
-	for (int i = 0; i < BOARD_HEIGHT; i++) {
-		for (int j = 0; j < BOARD_WIDTH; j++) {
-			m_board[i][j] = 0;
-		}
-	}
+template <int Width, int Height>
+void Board<Width, Height>::Reset() {
+	InitializeBoard();
+}
 
-}
\ No newline at end of file
+// ----- Board instantiations -----
+template class Board<10, 20>;
+template class Board<4, 20>;
+template class Board<10, 40>;
+template class Board<64, 20>;
+// --------------------------------
@@ -1,19 +1,27 @@
 /*****************************************************************************************
 /* File: Board.h
-/* Description: Class that stores and manages the state of the board tiles as a 2D array
+/* Description: Class that stores and manages the state of the board tiles as one
+/*				occupancy bitmask per row, plus a separate plane of tile colors
 /*
 /* Rachel Pearson 2022
 /*
 /*****************************************************************************************/
 
 // ------ Includes -----
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
 #include "Tetromino.h"
+#include "Zobrist.h"
 // ---------------------
 
 // ----- Constants -----
-constexpr auto BOARD_WIDTH = 10;
-constexpr auto BOARD_HEIGHT = 20;
 constexpr auto TILE_SIZE = 30;
+constexpr auto MAX_BOARD_WIDTH = 64;		// Widest board a row mask can hold
+constexpr auto MAX_BOARD_HEIGHT = 64;		// Tallest board a mask of cleared rows can hold
 // ---------------------
 
 // ------ Enums --------
@@ -21,24 +29,133 @@ enum {
 	EMPTY, TET, TET_PIVOT,
 	BLUE, GREEN, ORANGE, RED, PURPLE, YELLOW
 };
+
+// Board sizes that can be chosen at startup
+enum {
+	BOARD_STANDARD,		// 10 x 20
+	BOARD_NARROW,		// 4 x 20
+	BOARD_TALL,			// 10 x 40
+	BOARD_WIDE,			// 64 x 20
+	BOARD_SIZE_COUNT
+};
+// ---------------------
+
+// ------ Functions ----
+
+/*
+==================
+Counts the zero bits below the lowest set bit of a mask, which
+must not be 0
+==================
+*/
+inline int CountTrailingZeros(uint64_t mask) {
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward64(&index, mask);
+	return (int)index;
+#else
+	return __builtin_ctzll(mask);
+#endif
+}
+
+/*
+==================
+Finds how far a tile can fall down its column, using a mask of
+the filled rows of the column (bit i for row i). Shared by boards
+and the batched games, which keep the same column masks
+
+Parameters:
+>> column	Mask of the column's filled rows
+>> yTile	Row of the tile; may be above the board
+>> height	Number of rows in the column
+
+Returns:
+>> The number of rows the tile can move down
+==================
+*/
+inline int GetColumnDropDistance(uint64_t column, int yTile, int height) {
+	int firstRow = (yTile + 1 > 0) ? yTile + 1 : 0;
+	int landingRow = height;
+
+	if (firstRow < height) {
+		uint64_t below = column >> firstRow;
+		if (below != 0) {
+			landingRow = firstRow + CountTrailingZeros(below);
+		}
+	}
+	return landingRow - yTile - 1;
+}
 // ---------------------
 
 #pragma once
+
+// The board is a template over its dimensions, so that every size gets its own
+// kernels with the loop bounds and row mask type fixed at compile time. Only the
+// sizes instantiated at the bottom of Board.cpp (and named below) can be used
+template <int Width, int Height>
 class Board
 {
+	static_assert(Width > 0 && Width <= MAX_BOARD_WIDTH, "Unsupported board width");
+	static_assert(Height > 0 && Height <= MAX_BOARD_HEIGHT, "Unsupported board height");
+
 	public:
+		// Smallest unsigned type that holds one bit per tile of a row
+		typedef typename std::conditional<(Width <= 16), uint16_t,
+				typename std::conditional<(Width <= 32), uint32_t, uint64_t>::type>::type RowMask;
+
+		static constexpr int WIDTH = Width;
+		static constexpr int HEIGHT = Height;
+		static constexpr RowMask FULL_ROW_MASK = (RowMask)(Width == 64 ? ~0ull : (1ull << Width) - 1);
+
+		// Which rows of the board a placement can change, saved so that the
+		// placement can be undone. The rows themselves are saved separately,
+		// as UNDO_ROW_SIZE bytes for each of rows firstRow to lastRow
+		struct UndoRecord {
+			int firstRow;
+			int lastRow;					// Less than firstRow if no rows are saved
+			uint64_t fullRows;
+			uint64_t hash;
+		};
+		static constexpr int UNDO_ROW_SIZE = sizeof(RowMask) + 1 + Width;		// Mask, count and colors
+
 		Board();
 		int GetTile(int xTile, int yTile);
-		int ClearFilledRows();
-		void MapTetromino(Tetromino* tet);
+		int GetRowCount(int yTile);
+		int GetColumnHeight(int xTile);
+		int GetDropDistance(Tetromino* tet);
+		uint64_t GetHash();
+		uint64_t ClearFilledRows();
 		bool PlaceTetromino(Tetromino* tet);
+		UndoRecord GetUndoRecord(Tetromino* tet);
+		void SaveRows(const UndoRecord& record, uint8_t* rowData);
+		void RestoreRows(const UndoRecord& record, const uint8_t* rowData);
 		bool IsTetrominoAboveBoard(Tetromino* tet);
 		bool IsTileFilled(int xTile, int yTile);
-		void ClearTetromino();
+		RowMask GetRowMask(int yTile);
 		void Reset();
 
 	private:
-		int m_board[BOARD_HEIGHT][BOARD_WIDTH];		// The 2D array of board states
+		// Occupancy of each row as a bitmask; bit x is set when tile x of
+		// that row is filled by a placed Tetromino
+		RowMask m_rows[Height];
+
+		// Color of each placed tile, only read when drawing; the falling
+		// Tetromino is never written here, it is drawn as an overlay
+		uint8_t m_colors[Height][Width];
+
+		// Kept up to date as tiles are placed and rows are cleared, so
+		// that none of these need a scan of the board to find
+		uint8_t m_rowCounts[Height];		// Number of filled tiles in each row
+		uint64_t m_columns[Width];			// Occupancy of each column; bit y is set when row y is filled
+		uint64_t m_fullRows;				// Mask of rows that are filled and waiting to be cleared
+		uint64_t m_hash;					// Zobrist hash of which tiles are filled (colors are not hashed)
+
 		void InitializeBoard();
-		void ClearRow(int row);
 };
+
+// ----- Board instantiations -----
+typedef Board<10, 20> StandardBoard;
+typedef Board<4, 20> NarrowBoard;
+typedef Board<10, 40> TallBoard;
+typedef Board<64, 20> WideBoard;
+// --------------------------------
@@ -0,0 +1,307 @@
+/*****************************************************************************************
+/* File: Determinism.cpp
+/* Description: Traces of a game's state for checking that it plays out the same in
+/*				every build - a hash of the whole game state, and the board, every so
+/*				many ticks. Two traces of the same inputs can be compared to find the
+/*				first point where they differ, and what was different on the board
+/*
+/* Rachel Pearson 2022
+/*
+/*****************************************************************************************/
+
+#include "Determinism.h"
+
+/*
+==================
+Writes a number to a file, lowest byte first, so that traces are
+the same on every platform
+==================
+*/
+static void WriteNumber(FILE* file, uint64_t value, int bytes) {
+	uint8_t buffer[8];
+
+	for (int i = 0; i < bytes; i++) {
+		buffer[i] = (uint8_t)(value >> (i * 8));
+	}
+	fwrite(buffer, 1, bytes, file);
+}
+
+/*
+==================
+Reads a number written by WriteNumber
+
+Returns:
+>> False if the file ended first
+==================
+*/
+static bool ReadNumber(FILE* file, uint64_t* value, int bytes) {
+	uint8_t buffer[8];
+
+	if (fread(buffer, 1, bytes, file) != (size_t)bytes) {
+		return false;
+	}
+	*value = 0;
+	for (int i = 0; i < bytes; i++) {
+		*value |= (uint64_t)buffer[i] << (i * 8);
+	}
+	return true;
+}
+
+/*
+==================
+Constructor
+==================
+*/
+DeterminismTrace::DeterminismTrace() {
+	Reset(DEFAULT_TRACE_INTERVAL, 0, 0);
+}
+
+/*
+==================
+Clears the trace, ready to record a new game
+
+Parameters:
+>> interval		Ticks between checkpoints; 1 records every tick
+>> boardWidth	Size of the board the game is played on
+>> boardHeight
+==================
+*/
+void DeterminismTrace::Reset(int interval, int boardWidth, int boardHeight) {
+	m_interval = (interval > 0) ? interval : 1;
+	m_boardWidth = boardWidth;
+	m_boardHeight = boardHeight;
+	m_rulesetVersion = RULESET_VERSION;
+	m_checkpoints.clear();
+}
+
+/*
+==================
+Records a checkpoint of a game if it is due - every interval ticks,
+starting from tick 0, and once more when the game ends. Call it
+once before the first tick, and after every tick
+
+Parameters:
+>> game		The game being traced
+==================
+*/
+template <class BoardType>
+void DeterminismTrace::Record(Game<BoardType>* game) {
+	uint32_t tick = game->GetTickCount();
+
+	if (tick % m_interval != 0 && !game->IsGameOver()) {
+		return;
+	}
+	if (!m_checkpoints.empty() && m_checkpoints.back().tick == tick) {
+		return;
+	}
+
+	TraceCheckpoint checkpoint = {};
+	checkpoint.tick = tick;
+	checkpoint.hash = game->GetStateHash();
+	for (int i = 0; i < BoardType::HEIGHT; i++) {
+		checkpoint.rows[i] = game->GetBoard()->GetRowMask(i);
+	}
+	m_checkpoints.push_back(checkpoint);
+}
+
+/*
+==================
+Writes the trace to a file
+
+Parameters:
+>> path		File to write to; replaced if it exists
+
+Returns:
+>> True if the whole trace was written
+==================
+*/
+bool DeterminismTrace::Save(const char* path) {
+	FILE* file = fopen(path, "wb");
+	if (file == NULL) {
+		return false;
+	}
+
+	WriteNumber(file, TRACE_MAGIC, 4);
+	WriteNumber(file, TRACE_FORMAT_VERSION, 2);
+	WriteNumber(file, (uint64_t)m_rulesetVersion, 2);
+	WriteNumber(file, (uint64_t)m_interval, 4);
+	WriteNumber(file, (uint64_t)m_boardWidth, 2);
+	WriteNumber(file, (uint64_t)m_boardHeight, 2);
+	WriteNumber(file, m_checkpoints.size(), 4);
+	for (const TraceCheckpoint& checkpoint : m_checkpoints) {
+		WriteNumber(file, checkpoint.tick, 4);
+		WriteNumber(file, checkpoint.hash, 8);
+		for (int i = 0; i < m_boardHeight; i++) {
+			WriteNumber(file, checkpoint.rows[i], 8);
+		}
+	}
+
+	bool written = !ferror(file);
+	return (fclose(file) == 0) && written;
+}
+
+/*
+==================
+Reads a trace written by Save, replacing this one
+
+Parameters:
+>> path		File to read
+
+Returns:
+>> True if it was a whole trace this version can read
+==================
+*/
+bool DeterminismTrace::Load(const char* path) {
+	FILE* file = fopen(path, "rb");
+	if (file == NULL) {
+		return false;
+	}
+
+	uint64_t magic, formatVersion, rulesetVersion, interval, boardWidth, boardHeight, count;
+	bool read = ReadNumber(file, &magic, 4) && ReadNumber(file, &formatVersion, 2) &&
+				ReadNumber(file, &rulesetVersion, 2) && ReadNumber(file, &interval, 4) &&
+				ReadNumber(file, &boardWidth, 2) && ReadNumber(file, &boardHeight, 2) &&
+				ReadNumber(file, &count, 4);
+	if (!read || magic != (uint64_t)TRACE_MAGIC || formatVersion != TRACE_FORMAT_VERSION ||
+		boardHeight > MAX_BOARD_HEIGHT) {
+		fclose(file);
+		return false;
+	}
+
+	Reset((int)interval, (int)boardWidth, (int)boardHeight);
+	m_rulesetVersion = (int)rulesetVersion;
+	for (uint64_t i = 0; i < count && read; i++) {
+		TraceCheckpoint checkpoint = {};
+		uint64_t tick = 0;
+		read = ReadNumber(file, &tick, 4) && ReadNumber(file, &checkpoint.hash, 8);
+		for (int j = 0; j < m_boardHeight && read; j++) {
+			read = ReadNumber(file, &checkpoint.rows[j], 8);
+		}
+		checkpoint.tick = (uint32_t)tick;
+		m_checkpoints.push_back(checkpoint);
+	}
+
+	fclose(file);
+	return read;
+}
+
+// ------ Getters & Setters -----
+int DeterminismTrace::GetInterval() {
+	return m_interval;
+}
+
+int DeterminismTrace::GetBoardWidth() {
+	return m_boardWidth;
+}
+
+int DeterminismTrace::GetBoardHeight() {
+	return m_boardHeight;
+}
+
+// RULESET_VERSION of the build that recorded the trace
+int DeterminismTrace::GetRulesetVersion() {
+	return m_rulesetVersion;
+}
+
+int DeterminismTrace::GetCheckpointCount() {
+	return (int)m_checkpoints.size();
+}
+
+const TraceCheckpoint& DeterminismTrace::GetCheckpoint(int index) {
+	return m_checkpoints[index];
+}
+// ------------------------------
+
+/*
+==================
+Finds the first checkpoint where this trace and another differ -
+in tick, state hash or board - or where one of them ends before
+the other. Both must be of the same inputs, recorded with the same
+interval
+
+Parameters:
+>> other	The trace to compare with
+
+Returns:
+>> Where they first differ; checkpoint is -1 if they agree
+==================
+*/
+TraceDivergence DeterminismTrace::Compare(DeterminismTrace* other) {
+	TraceDivergence divergence = { -1, 0, 0 };
+	size_t count = (m_checkpoints.size() < other->m_checkpoints.size()) ? m_checkpoints.size()
+																		 : other->m_checkpoints.size();
+
+	for (size_t i = 0; i <= count; i++) {
+		bool same;
+		if (i == count) {
+			same = (m_checkpoints.size() == other->m_checkpoints.size());
+		}
+		else {
+			const TraceCheckpoint& a = m_checkpoints[i];
+			const TraceCheckpoint& b = other->m_checkpoints[i];
+			same = (a.tick == b.tick) && (a.hash == b.hash);
+			for (int j = 0; j < m_boardHeight && same; j++) {
+				same = (a.rows[j] == b.rows[j]);
+			}
+		}
+
+		if (!same) {
+			DeterminismTrace* longer = (i < m_checkpoints.size()) ? this : other;
+			divergence.checkpoint = (int)i;
+			divergence.tick = longer->m_checkpoints[i].tick;
+			return divergence;
+		}
+		if (i < count) {
+			divergence.lastGoodTick = m_checkpoints[i].tick;
+		}
+	}
+	return divergence;
+}
+
+/*
+==================
+Prints the boards of this trace and another at a checkpoint side by
+side, with the rows that differ marked
+
+Parameters:
+>> out			Where to print to
+>> other		The trace to compare with
+>> checkpoint	Index of the checkpoint to print
+==================
+*/
+void DeterminismTrace::WriteBoardDiff(FILE* out, DeterminismTrace* other, int checkpoint) {
+	DeterminismTrace* traces[2] = { this, other };
+	const TraceCheckpoint* checkpoints[2];
+
+	for (int i = 0; i < 2; i++) {
+		checkpoints[i] = (checkpoint < traces[i]->GetCheckpointCount()) ? &traces[i]->m_checkpoints[checkpoint] : NULL;
+		if (checkpoints[i] == NULL) {
+			fprintf(out, "Trace %d ends before checkpoint %d\n", i + 1, checkpoint);
+		}
+		else {
+			fprintf(out, "Trace %d: tick %u, hash %016llx\n", i + 1, checkpoints[i]->tick,
+					(unsigned long long)checkpoints[i]->hash);
+		}
+	}
+	if (checkpoints[0] == NULL || checkpoints[1] == NULL) {
+		return;
+	}
+
+	// '#' is a filled tile; rows that differ are marked with '<'
+	for (int y = 0; y < m_boardHeight; y++) {
+		for (int i = 0; i < 2; i++) {
+			for (int x = 0; x < m_boardWidth; x++) {
+				fputc(((checkpoints[i]->rows[y] >> x) & 1) ? '#' : '.', out);
+			}
+			fputs((i == 0) ? "   " : "", out);
+		}
+		fputs((checkpoints[0]->rows[y] != checkpoints[1]->rows[y]) ? "  <\n" : "\n", out);
+	}
+}
+
+// ----- Board instantiations -----
+template void DeterminismTrace::Record<StandardBoard>(Game<StandardBoard>*);
+template void DeterminismTrace::Record<NarrowBoard>(Game<NarrowBoard>*);
+template void DeterminismTrace::Record<TallBoard>(Game<TallBoard>*);
+template void DeterminismTrace::Record<WideBoard>(Game<WideBoard>*);
+// --------------------------------
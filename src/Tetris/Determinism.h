@@ -0,0 +1,70 @@
+/*****************************************************************************************
+/* File: Determinism.h
+/* Description: Traces of a game's state for checking that it plays out the same in
+/*				every build - a hash of the whole game state, and the board, every so
+/*				many ticks. Two traces of the same inputs can be compared to find the
+/*				first point where they differ, and what was different on the board
+/*
+/* Rachel Pearson 2022
+/*
+/*****************************************************************************************/
+
+// ------ Includes -----
+#include <stdio.h>
+#include <stdint.h>
+#include <vector>
+#include "Board.h"
+#include "Game.h"
+// ---------------------
+
+// ------ Constants -----
+constexpr auto TRACE_MAGIC = 0x43525454;			// "TTRC", little-endian
+constexpr auto TRACE_FORMAT_VERSION = 1;
+constexpr auto DEFAULT_TRACE_INTERVAL = 60;			// Ticks between checkpoints (once a second of play)
+constexpr auto TRACE_EXTENSION = ".trace";			// A replay's trace is stored next to it, with this added
+// ----------------------
+
+#pragma once
+
+// The state of a game at one tick
+struct TraceCheckpoint {
+	uint32_t tick;
+	uint64_t hash;								// Game::GetStateHash
+	uint64_t rows[MAX_BOARD_HEIGHT];			// Board row masks, top to bottom
+};
+
+// Where two traces first differ
+struct TraceDivergence {
+	int checkpoint;			// Index of the first checkpoint that differs, or -1 if they agree
+	uint32_t lastGoodTick;	// Last tick both agreed on; the game went wrong after it
+	uint32_t tick;			// Tick of the checkpoint that differs
+};
+
+// File layout (all numbers little-endian): u32 magic, u16 format version, u16 ruleset
+// version, u32 interval, u16 board width, u16 board height, u32 checkpoint count, then
+// for each checkpoint u32 tick, u64 hash and a u64 row mask per board row
+class DeterminismTrace
+{
+	public:
+		DeterminismTrace();
+		void Reset(int interval, int boardWidth, int boardHeight);
+		template <class BoardType>
+		void Record(Game<BoardType>* game);
+		bool Save(const char* path);
+		bool Load(const char* path);
+		int GetInterval();
+		int GetBoardWidth();
+		int GetBoardHeight();
+		int GetRulesetVersion();
+		int GetCheckpointCount();
+		const TraceCheckpoint& GetCheckpoint(int index);
+		TraceDivergence Compare(DeterminismTrace* other);
+		void WriteBoardDiff(FILE* out, DeterminismTrace* other, int checkpoint);
+
+	private:
+		int m_interval;
+		int m_boardWidth;
+		int m_boardHeight;
+		int m_rulesetVersion;
+		std::vector<TraceCheckpoint> m_checkpoints;
+};
@@ -13,68 +13,340 @@
 /*
 ==================
 Constructor
-Initialises Board, TetrominoController, and variables
+Initialises TetrominoController and variables, with the board
+and Tetromino held by value in the game state
 Spawns the first Tetromino
+
+Parameters:
+>> seed				Seed for the game's random numbers; the same
+					seed and inputs always give the same game
+>> randomizerType	How the shapes of Tetrominoes are picked
+					(RANDOMIZER_BAG etc.)
 ==================
 */
-Game::Game() {
-	srand((unsigned)time(NULL));
+template <class BoardType>
+Game<BoardType>::Game(uint64_t seed, int randomizerType)
+	: m_tetController(&m_state.board, &m_state.variables.tetromino) {
+	m_state.variables.random.Seed(seed);
+	m_state.variables.randomizer.Reset(randomizerType);
 
-	m_board = new Board;
-	m_tetController = new TetrominoController(m_board);
+	m_undoStack = NULL;
 
-	m_storedShape = -1;
-	m_storedColor = -1;
+	m_state.variables.storedShape = -1;
+	m_state.variables.storedColor = -1;
+	m_state.variables.canStore = true;
+	m_state.variables.canRelease = true;
+	m_state.variables.gameOver = false;
+	m_state.variables.tickCount = 0;
+	m_state.variables.pieceCount = 0;
 
-	m_score = 0;
-	m_nextShape = I;
-	// Random color value
-	m_nextColor = rand() % (YELLOW - BLUE + 1) + BLUE;
+	m_state.variables.score = 0;
+	m_state.variables.pieceQueue.Clear();
+	FillPieceQueue();
 
 	SpawnNextTetromino();
+	ResetLockDelay();
+}
+
+/*
+==================
+Moves the game on by one fixed step - carries out the player's
+inputs for this tick, then makes the Tetromino fall if it has
+waited long enough. A Tetromino resting on the stack is placed,
+and the next one spawned, once it has rested for the lock delay;
+moving or rotating it restarts the delay, up to MAX_LOCK_RESETS
+times for each new lowest row it reaches. Hard drop places it
+straight away
+
+Parameters:
+>> input	Mask of the INPUT_ bits pressed this tick
+
+Returns:
+>> True while the game is still going, false once it is over
+==================
+*/
+template <class BoardType>
+bool Game<BoardType>::Tick(uint32_t input) {
+	GameVariables* variables = &m_state.variables;
+
+	if (variables->gameOver) {
+		return false;
+	}
+
+	// A placement made this tick is undone back to here. The board can't
+	// change before then, so only the variables need keeping
+	GameVariables tickStart;
+	if (m_undoStack != NULL) {
+		tickStart = *variables;
+	}
+	variables->tickCount++;
+
+	bool moved = false;
+	if (input & INPUT_HOLD) {
+		PlayerHold();
+	}
+	if (input & INPUT_ROTATE_CW) {
+		moved |= PlayerRotate(CLOCKWISE);
+	}
+	if (input & INPUT_ROTATE_ACW) {
+		moved |= PlayerRotate(ANTICLOCKWISE);
+	}
+	if (input & INPUT_LEFT) {
+		moved |= PlayerMove(LEFT);
+	}
+	if (input & INPUT_RIGHT) {
+		moved |= PlayerMove(RIGHT);
+	}
+	if (input & INPUT_LEFT_WALL) {
+		while (PlayerMove(LEFT)) {
+			moved = true;
+		}
+	}
+	if (input & INPUT_RIGHT_WALL) {
+		while (PlayerMove(RIGHT)) {
+			moved = true;
+		}
+	}
+
+	// Moving a resting Tetromino restarts its lock delay, a limited number of times
+	RestartLockDelay(moved, &variables->lockTimer, &variables->lockResets);
+
+	if (input & INPUT_HARD_DROP) {
+		m_tetController.HardDropTetromino();
+		LockTetromino(PlaceTetromino(tickStart));
+		return !variables->gameOver;
+	}
+
+	// Gravity, which is faster while soft drop is held
+	if (++variables->fallTimer >= GetFallTicksForScore(variables->score, (input & INPUT_SOFT_DROP) != 0)) {
+		variables->fallTimer = 0;
+		PlayerMove(DOWN);
+	}
+
+	// A Tetromino resting on the stack is placed once its lock delay is up
+	if (CountLockDelay(variables->tetromino.GetPivotYTile(), !m_tetController.IsValidMovement(DOWN),
+					   &variables->lockTimer, &variables->lockResets, &variables->lowestY)) {
+		LockTetromino(PlaceTetromino(tickStart));
+	}
+
+	return !variables->gameOver;
+}
+
+/*
+==================
+Finishes off a placement - ends the game if the Tetromino could
+not be placed, otherwise spawns the next one
+
+Parameters:
+>> placed	Whether the Tetromino was placed successfully
+==================
+*/
+template <class BoardType>
+void Game<BoardType>::LockTetromino(bool placed) {
+	if (!placed) {
+		m_state.variables.gameOver = true;
+		return;
+	}
+	SpawnNextTetromino();
+	m_state.variables.canStore = true;
+	m_state.variables.canRelease = true;
+	ResetLockDelay();
+}
+
+/*
+==================
+Restarts the fall and lock delay timers, for a new player Tetromino
+==================
+*/
+template <class BoardType>
+void Game<BoardType>::ResetLockDelay() {
+	m_state.variables.fallTimer = 0;
+	m_state.variables.lockTimer = 0;
+	m_state.variables.lockResets = 0;
+	m_state.variables.lowestY = m_state.variables.tetromino.GetPivotYTile();
+}
+
+template <class BoardType>
+bool Game<BoardType>::IsGameOver() {
+	return m_state.variables.gameOver;
+}
+
+/*
+==================
+Get the number of ticks between the Tetromino falling, which
+gets shorter as the score goes up
+==================
+*/
+template <class BoardType>
+int Game<BoardType>::GetFallTicks() {
+	return GetFallTicksForScore(m_state.variables.score, false);
+}
+
+/*
+==================
+Get the number of ticks until the Tetromino next falls, if no
+inputs are given before then. Ticks before that only count down
+the timer, so a caller with nothing to do can sleep until then
+==================
+*/
+template <class BoardType>
+int Game<BoardType>::GetTicksUntilFall() {
+	int ticks = GetFallTicks() - m_state.variables.fallTimer;
+	return (ticks > 1) ? ticks : 1;
 }
 
 /*
 ==================
-Deconstructor
+Get the number of ticks until the Tetromino is placed, if it stays
+resting on the stack and no inputs are given before then
+
+Returns:
+>> Number of ticks, or 0 if the Tetromino isn't resting on the stack
 ==================
 */
-Game::~Game() {
-	delete(m_board);
-	delete(m_tetController);
+template <class BoardType>
+int Game<BoardType>::GetTicksUntilLock() {
+	if (m_tetController.IsValidMovement(DOWN)) {
+		return 0;
+	}
+	int ticks = LOCK_DELAY_TICKS - m_state.variables.lockTimer;
+	return (ticks > 1) ? ticks : 1;
 }
 
-Board* Game::GetBoard() {
-	return m_board;
+template <class BoardType>
+BoardType* Game<BoardType>::GetBoard() {
+	return &m_state.board;
 }
 
 // ------ Getters & Setters -----
-int Game::GetScore() {
-	return m_score;
+template <class BoardType>
+int Game<BoardType>::GetScore() {
+	return m_state.variables.score;
 }
 
-int Game::GetNextShape() {
-	return m_nextShape;
+template <class BoardType>
+int Game<BoardType>::GetPieceCount() {
+	return m_state.variables.pieceCount;
 }
 
-int Game::GetNextColor() {
-	return m_nextColor;
+template <class BoardType>
+uint32_t Game<BoardType>::GetTickCount() {
+	return m_state.variables.tickCount;
 }
 
-int Game::GetStoredShape() {
-	return m_storedShape;
+template <class BoardType>
+int Game<BoardType>::GetNextShape() {
+	return m_state.variables.pieceQueue.GetShape(0);
 }
 
-int Game::GetStoredColor() {
-	return m_storedColor;
+template <class BoardType>
+int Game<BoardType>::GetNextColor() {
+	return m_state.variables.pieceQueue.GetColor(0);
 }
 
-int Game::GetTetrominoColor() {
-	return m_tetController->GetTetromino()->GetColor();
+/*
+==================
+Get the queue of upcoming Tetrominoes, next one first; it is
+always full, so PIECE_QUEUE_CAPACITY of them can be read from it
+==================
+*/
+template <class BoardType>
+PieceQueue* Game<BoardType>::GetPieceQueue() {
+	return &m_state.variables.pieceQueue;
 }
 
-bool Game::HasStoredTetromino() {
-	return (m_storedShape != -1);
+template <class BoardType>
+int Game<BoardType>::GetStoredShape() {
+	return m_state.variables.storedShape;
+}
+
+template <class BoardType>
+int Game<BoardType>::GetStoredColor() {
+	return m_state.variables.storedColor;
+}
+
+template <class BoardType>
+Tetromino* Game<BoardType>::GetTetromino() {
+	return m_tetController.GetTetromino();
+}
+
+/*
+==================
+Get a 64-bit Zobrist hash of the board, the player Tetromino
+(shape, rotation and position), the queue of upcoming shapes and
+the stored shape. The board keeps its own hash up to date, so
+this is just a few key lookups
+==================
+*/
+template <class BoardType>
+uint64_t Game<BoardType>::GetHash() {
+	Tetromino* tet = m_tetController.GetTetromino();
+	PieceQueue* queue = &m_state.variables.pieceQueue;
+
+	uint64_t hash = m_state.board.GetHash() ^
+					ZobristTetrominoKey(ZOBRIST_FALLING_SALT, tet->GetShape(), tet->GetRotation(),
+										tet->GetPivotXTile(), tet->GetPivotYTile()) ^
+					ZobristTetrominoKey(ZOBRIST_STORED_SALT, m_state.variables.storedShape, 0, 0, 0);
+
+	// Each place in the queue gets its own keys
+	for (int i = 0; i < queue->GetCount(); i++) {
+		hash ^= ZobristTetrominoKey(ZOBRIST_NEXT_SALT, queue->GetShape(i), 0, i, 0);
+	}
+	return hash;
+}
+
+/*
+==================
+Get a 64-bit hash of the whole state of the game - GetHash, plus
+the score, timers, counters, flags, colors, randomizer and random
+number generator. Two runs of a game that agree on this after
+every tick have played out identically (apart from the colors of
+placed tiles, which only the view reads)
+==================
+*/
+template <class BoardType>
+uint64_t Game<BoardType>::GetStateHash() {
+	GameVariables* variables = &m_state.variables;
+	uint64_t hash = GetHash();
+	uint64_t values[] = {
+		(uint64_t)(uint32_t)variables->score,
+		(uint64_t)(uint32_t)variables->storedColor,
+		(uint64_t)(uint32_t)variables->tetromino.GetColor(),
+		((uint64_t)variables->canStore << 2) | ((uint64_t)variables->canRelease << 1) | (uint64_t)variables->gameOver,
+		(uint64_t)(uint32_t)variables->fallTimer,
+		((uint64_t)(uint32_t)variables->lockTimer << 32) | (uint32_t)variables->lockResets,
+		(uint64_t)(uint32_t)variables->lowestY,
+		(uint64_t)variables->tickCount,
+		(uint64_t)(uint32_t)variables->pieceCount,
+		variables->randomizer.GetHash(),
+		variables->random.GetHash()
+	};
+
+	for (uint64_t value : values) {
+		hash = SplitMix64(hash ^ value);
+	}
+	for (int i = 0; i < variables->pieceQueue.GetCount(); i++) {
+		hash = SplitMix64(hash ^ (uint64_t)variables->pieceQueue.GetColor(i));
+	}
+	return hash;
+}
+
+/*
+==================
+Get a copy of the player Tetromino moved down to where it would
+land, for drawing as a ghost
+==================
+*/
+template <class BoardType>
+Tetromino Game<BoardType>::GetGhostTetromino() {
+	Tetromino ghost = *m_tetController.GetTetromino();
+	ghost.SetPivotYTile(ghost.GetPivotYTile() + m_tetController.GetDropDistance());
+	return ghost;
+}
+
+template <class BoardType>
+bool Game<BoardType>::HasStoredTetromino() {
+	return (m_state.variables.storedShape != -1);
 }
 // ------------------------------
 
@@ -83,27 +355,13 @@ bool Game::HasStoredTetromino() {
 Attempts to clear rows and adds score based on rows cleared
 ==================
 */
-void Game::ClearRows()
+template <class BoardType>
+void Game<BoardType>::ClearRows()
 {
-	int rowsCleared;
-	rowsCleared = m_board->ClearFilledRows();
-
-	switch (rowsCleared) {
-		case 0:
-			break;
-		case 1:
-			m_score += SINGLE_ROW_SCORE;
-			break;
-		case 2:
-			m_score += DOUBLE_ROW_SCORE;
-			break;
-		case 3:
-			m_score += TRIPLE_ROW_SCORE;
-			break;
-		default:
-			m_score += TETRIS_ROW_SCORE;
-			break;
-		}
+	uint64_t clearedRows = m_state.board.ClearFilledRows();
+	int rowsCleared = (int)std::bitset<64>(clearedRows).count();
+
+	m_state.variables.score += GetRowClearScore(rowsCleared);
 }
 
 /*
@@ -117,12 +375,11 @@ Returns:
 >> True if the player could move, false if it could not
 ==================
 */
-bool Game::PlayerMove(int direction)
+template <class BoardType>
+bool Game<BoardType>::PlayerMove(int direction)
 {
-	if (m_tetController->IsValidMovement(direction)) {
-		m_tetController->MoveTetromino(direction);
-		m_board->ClearTetromino();
-		m_board->MapTetromino(m_tetController->GetTetromino());
+	if (m_tetController.IsValidMovement(direction)) {
+		m_tetController.MoveTetromino(direction);
 		return true;
 	}
 	return false;
@@ -131,26 +388,58 @@ bool Game::PlayerMove(int direction)
 /*
 ==================
 Attempts to rotate the player Tetromino, does nothing on failure
+
+Parameters:
+>> direction	CLOCKWISE or ANTICLOCKWISE
+
+Returns:
+>> True if the Tetromino was rotated, false if not
 ==================
 */
-void Game::PlayerRotate()
+template <class BoardType>
+bool Game<BoardType>::PlayerRotate(int direction)
 {
-	m_tetController->RotateTetromino();
-	m_board->ClearTetromino();
-	m_board->MapTetromino(m_tetController->GetTetromino());
+	return m_tetController.RotateTetromino(direction);
+}
+
+/*
+==================
+Attempts to place the player Tetromino; undoing it goes back to
+just before the placement
+
+Returns:
+>> True if the player Tetromino could be placed, false if not
+==================
+*/
+template <class BoardType>
+bool Game<BoardType>::PlayerPlace() {
+	return PlaceTetromino(m_state.variables);
 }
 
 /*
 ==================
-Attempts to place the player Tetromino
+Places the player Tetromino, recording an undo entry for the
+placement first if an undo stack is attached
+
+Parameters:
+>> undoVariables	The game variables that undoing the placement
+					goes back to; only read if an undo stack is
+					attached
 
 Returns:
 >> True if the player Tetromino could be placed, false if not
 ==================
 */
-bool Game::PlayerPlace() {
-	bool success = m_board->PlaceTetromino(m_tetController->GetTetromino());
+template <class BoardType>
+bool Game<BoardType>::PlaceTetromino(const GameVariables& undoVariables) {
+	// Save what this placement changes, so it can be undone
+	if (m_undoStack != NULL) {
+		m_undoStack->Push(&m_state.board, m_tetController.GetTetromino(), undoVariables);
+	}
+
+	bool success = m_state.board.PlaceTetromino(m_tetController.GetTetromino());
 	if (success) {
+		m_state.variables.pieceCount++;
 		ClearRows();
 	}
 	return success;
@@ -158,22 +447,78 @@ bool Game::PlayerPlace() {
 
 /*
 ==================
-Spawns the next Tetromino in the list, with a random color
+Drops the player Tetromino straight to where it would land and
+places it there
+
+Returns:
+>> True if the player Tetromino could be placed, false if not
 ==================
 */
-void Game::SpawnNextTetromino() {
-	m_tetController->SpawnTetromino(m_nextShape, m_nextColor);
+template <class BoardType>
+bool Game<BoardType>::PlayerHardDrop() {
+	m_tetController.HardDropTetromino();
+	return PlayerPlace();
+}
 
-	if (m_nextShape == Z) {
-		m_nextShape = I;
+/*
+==================
+Stores the player Tetromino, or releases the stored one in its
+place. Storing is not allowed again until the released Tetromino
+is placed, and releasing not until the next one spawns
+
+Returns:
+>> True if a Tetromino was stored or released, false if not
+==================
+*/
+template <class BoardType>
+bool Game<BoardType>::PlayerHold() {
+	if (HasStoredTetromino()) {
+		if (!m_state.variables.canRelease) {
+			return false;
+		}
+		ReleaseStoredTetromino();
+		m_state.variables.canStore = false;
 	}
 	else {
-		m_nextShape++;
+		if (!m_state.variables.canStore) {
+			return false;
+		}
+		StoreTetromino();
+		m_state.variables.canRelease = false;
 	}
-	m_nextColor = rand() % (YELLOW - BLUE + 1) + BLUE;
+	ResetLockDelay();
+	return true;
+}
 
-	m_board->ClearTetromino();
-	m_board->MapTetromino(m_tetController->GetTetromino());
+/*
+==================
+Spawns the next Tetromino in the queue, and tops the queue up
+==================
+*/
+template <class BoardType>
+void Game<BoardType>::SpawnNextTetromino() {
+	PieceQueue* queue = &m_state.variables.pieceQueue;
+
+	m_tetController.SpawnTetromino(queue->GetShape(0), queue->GetColor(0));
+	queue->Pop();
+	FillPieceQueue();
+}
+
+/*
+==================
+Adds Tetrominoes to the back of the queue until it is full, with
+shapes from the randomizer and random colors
+==================
+*/
+template <class BoardType>
+void Game<BoardType>::FillPieceQueue() {
+	GameVariables* variables = &m_state.variables;
+
+	while (variables->pieceQueue.GetCount() < PIECE_QUEUE_CAPACITY) {
+		int shape = variables->randomizer.NextShape(&variables->random);
+		int color = variables->random.NextInt(YELLOW - BLUE + 1) + BLUE;
+		variables->pieceQueue.Push(shape, color);
+	}
 }
 
 /*
@@ -181,9 +526,10 @@ void Game::SpawnNextTetromino() {
 Stores the current Tetromino and spawns the next
 ==================
 */
-void Game::StoreTetromino() {
-	m_storedShape = m_tetController->GetTetromino()->GetShape();
-	m_storedColor = m_tetController->GetTetromino()->GetColor();
+template <class BoardType>
+void Game<BoardType>::StoreTetromino() {
+	m_state.variables.storedShape = m_tetController.GetTetromino()->GetShape();
+	m_state.variables.storedColor = m_tetController.GetTetromino()->GetColor();
 	SpawnNextTetromino();
 }
 
@@ -192,27 +538,119 @@ void Game::StoreTetromino() {
 Releases the stored Tetromino
 ==================
 */
-void Game::ReleaseStoredTetromino() {
-	m_tetController->SpawnTetromino(m_storedShape, m_storedColor);
-	m_storedShape = -1;
-	m_storedColor = -1;
+template <class BoardType>
+void Game<BoardType>::ReleaseStoredTetromino() {
+	m_tetController.SpawnTetromino(m_state.variables.storedShape, m_state.variables.storedColor);
+	m_state.variables.storedShape = -1;
+	m_state.variables.storedColor = -1;
 }
 
 /*
 ==================
-Resets the Tetromino, board, score, and next shape
+Resets the board, score, and upcoming Tetrominoes, and spawns the
+first Tetromino again. The same type of randomizer is kept
+
+Parameters:
+>> seed		Seed for the new game's random numbers
 ==================
 */
-void Game::Reset()
+template <class BoardType>
+void Game<BoardType>::Reset(uint64_t seed)
 {
-	m_tetController->ResetTetromino();
-	m_board->Reset();
-	m_score = 0;
-	m_nextShape = I + 1;
-	m_nextColor = rand() % (YELLOW - BLUE + 1) + BLUE;
-	m_storedShape = -1;
-	m_storedColor = -1;
+	m_state.variables.random.Seed(seed);
+	m_state.variables.randomizer.Reset(m_state.variables.randomizer.GetType());
+	m_state.board.Reset();
+	m_state.variables.score = 0;
+	m_state.variables.pieceQueue.Clear();
+	FillPieceQueue();
+	m_state.variables.storedShape = -1;
+	m_state.variables.storedColor = -1;
+	m_state.variables.canStore = true;
+	m_state.variables.canRelease = true;
+	m_state.variables.gameOver = false;
+	m_state.variables.tickCount = 0;
+	m_state.variables.pieceCount = 0;
+	if (m_undoStack != NULL) {
+		m_undoStack->Clear();
+	}
+
+	SpawnNextTetromino();
+	ResetLockDelay();
+}
+
+/*
+==================
+Copies the whole state of the game into a snapshot
+
+Parameters:
+>> state	The snapshot to copy into
+==================
+*/
+template <class BoardType>
+void Game<BoardType>::SaveState(GameState<BoardType>* state) {
+	memcpy(state, &m_state, sizeof(m_state));
+}
+
+/*
+==================
+Restores the whole state of the game from a snapshot. Undo
+entries are for the state being replaced, so they are dropped
+
+Parameters:
+>> state	The snapshot to restore
+==================
+*/
+template <class BoardType>
+void Game<BoardType>::LoadState(GameState<BoardType>* state) {
+	memcpy(&m_state, state, sizeof(m_state));
+	if (m_undoStack != NULL) {
+		m_undoStack->Clear();
+	}
+}
+
+/*
+==================
+Attaches an undo stack, which every placement from now on is
+recorded to. The caller owns the stack, which must outlive its
+use by the game; games without one don't record placements
 
-	m_board->ClearTetromino();
-	m_board->MapTetromino(m_tetController->GetTetromino());
+Parameters:
+>> undoStack	The stack to record to, or NULL to stop recording
+==================
+*/
+template <class BoardType>
+void Game<BoardType>::SetUndoStack(UndoStack<BoardType>* undoStack) {
+	m_undoStack = undoStack;
 }
+
+/*
+==================
+Undoes the most recent placement - puts back the board rows it
+changed, and goes back to the start of the tick it was made on (or
+to just before it, for PlayerPlace and PlayerHardDrop), so the
+whole state is as it was then
+
+Returns:
+>> True if a placement was undone, false if there were none left
+   or no undo stack is attached
+==================
+*/
+template <class BoardType>
+bool Game<BoardType>::UndoPlacement() {
+	if (m_undoStack == NULL) {
+		return false;
+	}
+	return m_undoStack->Pop(&m_state.board, &m_state.variables);
+}
+
+template <class BoardType>
+int Game<BoardType>::GetUndoCount() {
+	return (m_undoStack != NULL) ? m_undoStack->GetCount() : 0;
+}
+
+// ----- Board instantiations -----
+template class Game<StandardBoard>;
+template class Game<NarrowBoard>;
+template class Game<TallBoard>;
+template class Game<WideBoard>;
+// --------------------------------
@@ -9,9 +9,11 @@
 /*****************************************************************************************/
 
 // ------ Includes -----
-#include <stdlib.h>
-#include <time.h>
+#include <bitset>
+#include <stdint.h>
 #include "TetrominoController.h"
+#include "GameState.h"
+#include "UndoStack.h"
 // ---------------------
 
 // ------ Constants -----
@@ -19,38 +21,182 @@ constexpr auto SINGLE_ROW_SCORE = 40;
 constexpr auto DOUBLE_ROW_SCORE = 100;
 constexpr auto TRIPLE_ROW_SCORE = 300;
 constexpr auto TETRIS_ROW_SCORE = 1200;
+
+// The game runs in fixed steps, so fall rates are in ticks rather than ms
+constexpr auto TICK_RATE = 60;					// Ticks per second of game time
+constexpr auto INIT_FALL_TICKS = 45;			// Ticks between the Tetromino falling, to start with
+constexpr auto FALL_TICKS_DECREMENT = 3;		// Taken off the fall rate every DIFFICULTY_INCREASE_RATE points
+constexpr auto MIN_FALL_TICKS = 1;
+constexpr auto DIFFICULTY_INCREASE_RATE = 200;
+constexpr auto SOFT_DROP_FALL_TICKS = 2;		// Fall rate while soft drop is held, if faster than gravity
+constexpr auto LOCK_DELAY_TICKS = 30;			// Ticks a Tetromino rests on the stack before it is placed
+constexpr auto MAX_LOCK_RESETS = 15;			// Moves or rotations that can restart the lock delay, per
+												// Tetromino, before it next reaches a new lowest row
+
+// Goes up whenever the rules change in a way that would play the same inputs out
+// differently, so that old replays can be told apart
+constexpr auto RULESET_VERSION = 2;
+// ---------------------
+
+// ------ Enums --------
+
+// Player inputs for one tick, as bits of a mask; each set bit is one press,
+// apart from soft drop, which is set on every tick that it is held
+enum {
+	INPUT_LEFT = 1 << 0,
+	INPUT_RIGHT = 1 << 1,
+	INPUT_SOFT_DROP = 1 << 2,
+	INPUT_HARD_DROP = 1 << 3,
+	INPUT_ROTATE_CW = 1 << 4,
+	INPUT_ROTATE_ACW = 1 << 5,
+	INPUT_HOLD = 1 << 6,
+	INPUT_LEFT_WALL = 1 << 7,		// Move left as far as the Tetromino will go
+	INPUT_RIGHT_WALL = 1 << 8		// Move right as far as the Tetromino will go
+};
+// ---------------------
+
+// ------ Functions ----
+// The rules below are shared by Game and BatchGame, so that the two can't drift apart
+
+/*
+==================
+Get the score for clearing a number of rows with one placement
+==================
+*/
+inline int GetRowClearScore(int rowsCleared) {
+	switch (rowsCleared) {
+		case 0:
+			return 0;
+		case 1:
+			return SINGLE_ROW_SCORE;
+		case 2:
+			return DOUBLE_ROW_SCORE;
+		case 3:
+			return TRIPLE_ROW_SCORE;
+		default:
+			return TETRIS_ROW_SCORE;
+	}
+}
+
+/*
+==================
+Get the number of ticks between the Tetromino falling at a score,
+which gets shorter as the score goes up
+
+Parameters:
+>> score		The game's score
+>> softDrop		Whether soft drop is held, which makes it fall at
+				SOFT_DROP_FALL_TICKS if that is faster
+==================
+*/
+inline int GetFallTicksForScore(int score, bool softDrop) {
+	int fallTicks = INIT_FALL_TICKS - FALL_TICKS_DECREMENT * (score / DIFFICULTY_INCREASE_RATE);
+	fallTicks = (fallTicks > MIN_FALL_TICKS) ? fallTicks : MIN_FALL_TICKS;
+	return (softDrop && fallTicks > SOFT_DROP_FALL_TICKS) ? SOFT_DROP_FALL_TICKS : fallTicks;
+}
+
+/*
+==================
+Restarts the lock delay of a Tetromino resting on the stack that
+has been moved or rotated, if it has restarts left
+
+Parameters:
+>> moved		Whether the Tetromino moved or rotated this tick
+>> lockTimer	Ticks it has rested for
+>> lockResets	Times the delay has been restarted
+==================
+*/
+inline void RestartLockDelay(bool moved, int32_t* lockTimer, int32_t* lockResets) {
+	if (moved && *lockTimer > 0 && *lockResets < MAX_LOCK_RESETS) {
+		*lockTimer = 0;
+		(*lockResets)++;
+	}
+}
+
+/*
+==================
+Counts one tick of the lock delay, once the Tetromino has fallen
+for the tick. Reaching a new lowest row gives back the restarts,
+and a Tetromino that can't move down counts towards being placed
+
+Parameters:
+>> yTile		Row of the Tetromino's pivot
+>> grounded		Whether it can't move down
+>> lockTimer	Ticks it has rested for
+>> lockResets	Times the delay has been restarted
+>> lowestY		Lowest row its pivot has reached
+
+Returns:
+>> True once it has rested for the lock delay, and is to be placed
+==================
+*/
+inline bool CountLockDelay(int yTile, bool grounded, int32_t* lockTimer, int32_t* lockResets, int32_t* lowestY) {
+	if (yTile > *lowestY) {
+		*lowestY = yTile;
+		*lockResets = 0;
+	}
+	*lockTimer = grounded ? *lockTimer + 1 : 0;
+	return *lockTimer >= LOCK_DELAY_TICKS;
+}
 // ---------------------
 
 #pragma once
+
+// The rules of the game, with no dependency on SDL or the clock; Tick() moves the game
+// on by one fixed step, so it can be run as fast as wanted without a display.
+// It can't be copied, as its controller points into its own state; take snapshots
+// with SaveState and LoadState instead
+template <class BoardType>
 class Game
 {
 	public:
-		Game();
-		~Game();
-		Board* GetBoard();
+		Game(uint64_t seed, int randomizerType);
+		Game(const Game&) = delete;
+		Game& operator=(const Game&) = delete;
+		bool Tick(uint32_t input);
+		bool IsGameOver();
+		int GetFallTicks();
+		int GetTicksUntilFall();
+		int GetTicksUntilLock();
+		BoardType* GetBoard();
 		int GetScore();
+		int GetPieceCount();
+		uint32_t GetTickCount();
+		uint64_t GetHash();
+		uint64_t GetStateHash();
 		int GetNextShape();
 		int GetNextColor();
+		PieceQueue* GetPieceQueue();
 		int GetStoredShape();
 		int GetStoredColor();
-		int GetTetrominoColor();
+		Tetromino* GetTetromino();
+		Tetromino GetGhostTetromino();
 		bool PlayerMove(int direction);
-		void PlayerRotate();
+		bool PlayerRotate(int direction);
 		bool PlayerPlace();
+		bool PlayerHardDrop();
+		bool PlayerHold();
 		void SpawnNextTetromino();
 		void StoreTetromino();
 		bool HasStoredTetromino();
 		void ClearRows();
 		void ReleaseStoredTetromino();
-		void Reset();
+		void Reset(uint64_t seed);
+		void SaveState(GameState<BoardType>* state);
+		void LoadState(GameState<BoardType>* state);
+		void SetUndoStack(UndoStack<BoardType>* undoStack);
+		bool UndoPlacement();
+		int GetUndoCount();
 
 	private:
-		TetrominoController* m_tetController;
-		Board* m_board;
-		int m_nextShape;		// Next Tetromino's shape
-		int m_nextColor;		// Next Tetromino's color (random)
-		int m_score;			// Current score
-		int m_storedShape;		// Stored Tetromino's shape
-		int m_storedColor;		// Stored Tetromino's color
+		GameState<BoardType> m_state;						// Board and game variables
+		TetrominoController<BoardType> m_tetController;		// Works on the board and Tetromino in m_state
+
+		UndoStack<BoardType>* m_undoStack;					// Placements are only recorded when set
+
+		bool PlaceTetromino(const GameVariables& undoVariables);
+		void LockTetromino(bool placed);
+		void ResetLockDelay();
+		void FillPieceQueue();
 };
 
@@ -9,154 +9,425 @@
 
 #include "GameController.h"
 
-const auto FPS = 30;
-const auto INIT_FALL_RATE = 750;
-const auto FALL_RATE_INCREMENT = 50;
-const auto DIFFICULTY_INCREASE_RATE = 200;
+/*
+==================
+Constructor
 
-GameController::GameController()
+Parameters:
+>> options	Options chosen on the command line
+==================
+*/
+template <class BoardType>
+GameController<BoardType>::GameController(const GameOptions& options)
 {
-    m_game = new Game();
-    m_view = new View();
-
-    m_canReleaseStoredTet = true;
-    m_canStoreTet = true;
+    uint64_t seed = (uint64_t)time(NULL);
+    m_game = new Game<BoardType>(seed, RANDOMIZER_BAG);
+    m_view = new View(BoardType::WIDTH, BoardType::HEIGHT);
+    m_view->SetPieceQueue(m_game->GetPieceQueue());
+    m_traceInterval = options.traceInterval;
+    m_input = 0;
+    m_repeat.SetTiming(options.dasTicks, options.arrTicks);
+    m_keyPressed = false;
+    m_printStats = options.printStats;
+    SetState(STATE_TITLE);
 
     quit = false;
-    
-    m_fallRate = INIT_FALL_RATE;
-    m_fallTime1 = 0;
-    m_fallTime2 = 0;
 }
 
 /*
 ==================
-Starts the game - runs the main game loop, checking for input and
-telling game objects what to do
+Starts the game - runs the main game loop. The controller is
+stepped at a fixed SIMULATION_RATE, catching up on however many ticks
+have come due since the last pass. Between passes the loop sleeps
+until the next tick that can change anything, or until an event
+arrives, and a frame is only drawn when something has changed -
+at most RENDER_RATE times a second. Nothing in the loop blocks
+for longer than that, so events are handled in every state
 ==================
 */
-void GameController::StartGame() {
-    // Initial START GAME message
-    m_view->DrawBoard(m_game->GetBoard(), m_game->GetTetrominoColor());
-    m_view->DrawStartText();
-    m_view->Update();
-    SDL_Delay(1000);
-
-    SDL_Event event;
+template <class BoardType>
+void GameController<BoardType>::StartGame() {
+    uint64_t frequency = SDL_GetPerformanceFrequency();
+    uint64_t tickLength = frequency / SIMULATION_RATE;
+    uint64_t frameLength = frequency / RENDER_RATE;
+    uint64_t previous = SDL_GetPerformanceCounter();
+    uint64_t nextFrame = previous;
+    uint64_t accumulator = 0;
+    uint64_t maxLag = MAX_TICKS_PER_FRAME * tickLength;
 
-    m_fallTime1 = SDL_GetTicks();
+    m_stats = {};
+    m_stats.startCounter = previous;
 
     // Main game loop
     while (!quit) {
+        PollEvents();
+
+        uint64_t now = SDL_GetPerformanceCounter();
+        accumulator += now - previous;
+        previous = now;
+
+        // After a stall (e.g. the window being dragged) drop the time
+        // that can't be caught up on, rather than falling ever further behind
+        if (accumulator > maxLag) {
+            accumulator = maxLag;
+        }
+        // Each tick gets the events from before it came due
+        while (accumulator >= tickLength && !quit) {
+            HandleEvents(now - accumulator + tickLength);
+            StepState();
+            accumulator -= tickLength;
+        }
+
+        // The rest are for the next tick, which is never before now
+        HandleEvents(NO_DEADLINE);
+        m_stats.passCount++;
+
+        if (m_dirty && now >= nextFrame) {
+            UpdateView();
+            m_dirty = false;
+            nextFrame = now + frameLength;
+            m_stats.frameCount++;
+        }
+
+        // Sleep until the next tick that does something, or a frame
+        // that is waiting to be drawn. The ticks in between are run
+        // all at once on waking, so allow for catching up on them
+        uint64_t deadline = NO_DEADLINE;
+        int ticks = GetTicksUntilWake();
+        maxLag = MAX_TICKS_PER_FRAME * tickLength;
+        if (ticks > 0) {
+            deadline = previous + ticks * tickLength - accumulator;
+            maxLag += ticks * tickLength;
+        }
+        if (m_dirty && nextFrame < deadline) {
+            deadline = nextFrame;
+        }
+        if (!quit) {
+            WaitForEvents(deadline);
+        }
+    }
+
+    QuitGame();
+}
+
+/*
+==================
+Takes the events waiting in SDL's queue, noting when each arrived
+from its timestamp, so that a key pressed while the loop was busy
+still counts from the tick it was pressed in rather than the one
+the loop got round to it in
+==================
+*/
+template <class BoardType>
+void GameController<BoardType>::PollEvents() {
+    uint64_t frequency = SDL_GetPerformanceFrequency();
+    uint64_t now = SDL_GetPerformanceCounter();
+    Uint32 nowMs = SDL_GetTicks();
+    QueuedEvent queued;
+
+    while (SDL_PollEvent(&queued.event)) {
+        uint64_t age = (uint64_t)(Uint32)(nowMs - queued.event.common.timestamp) * frequency / 1000;
+        queued.counter = (age < now) ? now - age : 0;
+        m_events.push_back(queued);
+    }
+}
+
+/*
+==================
+Handles the queued events that arrived before a given time. Key
+presses are kept until a tick uses them, so none are lost when a
+pass of the loop doesn't tick
+
+Parameters:
+>> before	Performance counter value; NO_DEADLINE handles every event
+==================
+*/
+template <class BoardType>
+void GameController<BoardType>::HandleEvents(uint64_t before) {
+    size_t handled = 0;
+
+    for (; handled < m_events.size() && m_events[handled].counter < before; handled++) {
+        SDL_Event* event = &m_events[handled].event;
+
         // Close window
-        while (SDL_PollEvent(&event)) {
-            if (event.type == SDL_QUIT) {
-                quit = true;
-            }
-            // Movement checking
-            else if (event.type == SDL_KEYDOWN) {
-                switch (event.key.keysym.sym) {
-                    case SDLK_LEFT:
-                        m_game->PlayerMove(LEFT);
-                        break;
-                    case SDLK_RIGHT:
-                        m_game->PlayerMove(RIGHT);
-                        break;
-                    case SDLK_DOWN:
-                        if (!m_game->PlayerMove(DOWN)) {
-                            if (!m_game->PlayerPlace()) {
-                                GameOver();
-                            }
-                            m_game->SpawnNextTetromino();
-                            m_canReleaseStoredTet = true;
-                            m_canStoreTet = true;
-                        }
-                        break;
-                    case SDLK_r:
-                        m_game->PlayerRotate();
-                        break;
-                    case SDLK_h:
-                        if (m_game->HasStoredTetromino()) {
-                            if (m_canReleaseStoredTet) {
-                                m_game->ReleaseStoredTetromino();
-                                m_canStoreTet = false;
-                            }
-                        }
-                        else if (m_canStoreTet) {
-                            m_game->StoreTetromino();
-                            m_game->SpawnNextTetromino();
-                            m_canReleaseStoredTet = false;
-                        }
-                        break;
-                    // Quit game
-                    case SDLK_ESCAPE:
-                        quit = true;
-                        break;
+        if (event->type == SDL_QUIT) {
+            quit = true;
+        }
+        else if (event->type == SDL_WINDOWEVENT) {
+            // Keys let go while the window is in the background are never seen
+            if (event->window.event == SDL_WINDOWEVENT_FOCUS_LOST) {
+                m_repeat.ReleaseAll();
+                if (m_state == STATE_PLAYING) {
+                    SetState(STATE_PAUSED);
                 }
             }
+            m_dirty = true;
+        }
+        // Held keys are tracked from KEYDOWN to KEYUP, so the OS's own repeats are ignored
+        else if (event->type == SDL_KEYDOWN && event->key.repeat == 0) {
+            m_keyPressed = true;
+            HandleKey(event->key.keysym.sym, true);
         }
+        else if (event->type == SDL_KEYUP) {
+            HandleKey(event->key.keysym.sym, false);
+        }
+    }
+    m_events.erase(m_events.begin(), m_events.begin() + handled);
+}
 
-        // Update fall rate
-        m_fallRate = INIT_FALL_RATE - FALL_RATE_INCREMENT * 
-                     (m_game->GetScore() / DIFFICULTY_INCREASE_RATE);
+/*
+==================
+Turns a key going down or up into input for the game
 
-        // If enough time has passed, make Tetromino fall
-        m_fallTime2 = SDL_GetTicks();
-        if ((m_fallTime2 - m_fallTime1) > m_fallRate) {
-            if (m_game->PlayerMove(DOWN)) {
-                m_fallTime1 = SDL_GetTicks();
+Parameters:
+>> key		The key
+>> down		True if it went down, false if it came up
+==================
+*/
+template <class BoardType>
+void GameController<BoardType>::HandleKey(SDL_Keycode key, bool down) {
+    // Movement checking - these keys repeat for as long as they are held
+    uint32_t repeatInput = (key == SDLK_LEFT) ? INPUT_LEFT :
+                           (key == SDLK_RIGHT) ? INPUT_RIGHT :
+                           (key == SDLK_DOWN) ? INPUT_SOFT_DROP : 0;
+    if (repeatInput != 0) {
+        if (down) {
+            m_repeat.Press(repeatInput);
+        }
+        else {
+            m_repeat.Release(repeatInput);
+        }
+        return;
+    }
+    if (!down) {
+        return;
+    }
+
+    switch (key) {
+        case SDLK_SPACE:
+            m_input |= INPUT_HARD_DROP;
+            break;
+        case SDLK_r:
+            m_input |= INPUT_ROTATE_CW;
+            break;
+        case SDLK_e:
+            m_input |= INPUT_ROTATE_ACW;
+            break;
+        case SDLK_h:
+            m_input |= INPUT_HOLD;
+            break;
+        case SDLK_p:
+            if (m_state == STATE_PLAYING) {
+                SetState(STATE_PAUSED);
             }
-            else {
-                if (!m_game->PlayerPlace()) {
-                    GameOver();
-                }
-                m_game->SpawnNextTetromino();
-                m_canReleaseStoredTet = true;
-                m_canStoreTet = true;
+            else if (m_state == STATE_PAUSED) {
+                SetState(STATE_PLAYING);
             }
-        }
+            break;
+        // Quit game
+        case SDLK_ESCAPE:
+            quit = true;
+            break;
+    }
+}
 
-        UpdateView();
+/*
+==================
+Moves to a new state, starting its timer
+
+Parameters:
+>> state	The STATE_ value to move to
+==================
+*/
+template <class BoardType>
+void GameController<BoardType>::SetState(int state) {
+    m_state = state;
+    m_stateTicks = 0;
+    m_dirty = true;
 
-        SDL_Delay(1000 / FPS);
+    if (state == STATE_GAME_OVER) {
+        EndReplay();
     }
+    // Each countdown, from the title or after a game over, starts a new
+    // game, so a replay is only made for games that are actually played
+    else if (state == STATE_COUNTDOWN) {
+        uint64_t seed = (uint64_t)time(NULL);
+        m_game->Reset(seed);
+        StartReplay(seed);
+    }
+}
 
-    QuitGame();
+/*
+==================
+Steps the controller by one tick - ticks the game while it is being
+played, and otherwise moves between the screens shown before and
+after each game when their time is up or a key is pressed
+==================
+*/
+template <class BoardType>
+void GameController<BoardType>::StepState() {
+    bool keyPressed = m_keyPressed;
+    m_keyPressed = false;
+    m_stateTicks++;
+
+    switch (m_state) {
+        case STATE_TITLE:
+            if (keyPressed) {
+                SetState(STATE_COUNTDOWN);
+            }
+            break;
+        case STATE_COUNTDOWN:
+            if (m_stateTicks >= COUNTDOWN_TICKS) {
+                SetState(STATE_PLAYING);
+            }
+            break;
+        case STATE_PLAYING:
+            StepGame();
+            return;
+        case STATE_GAME_OVER:
+            if (m_stateTicks >= GAME_OVER_TICKS || (keyPressed && m_stateTicks >= GAME_OVER_SKIP_TICKS)) {
+                SetState(STATE_COUNTDOWN);
+            }
+            break;
+        case STATE_PAUSED:
+            break;
+    }
+
+    // Keys pressed outside of play aren't passed on to the game, but
+    // held keys keep charging, so a shift can be lined up in the countdown
+    m_input = 0;
+    m_repeat.Tick();
+}
+
+/*
+==================
+Get the number of ticks until the next one that may do something,
+so that the loop can sleep through the ones before it
+
+Returns:
+>> Number of ticks, or 0 if nothing happens until a key is pressed
+==================
+*/
+template <class BoardType>
+int GameController<BoardType>::GetTicksUntilWake() {
+    if (m_input != 0 || m_keyPressed) {
+        return 1;
+    }
+
+    switch (m_state) {
+        case STATE_COUNTDOWN:
+            return COUNTDOWN_TICKS - m_stateTicks;
+        case STATE_PLAYING: {
+            int ticks = m_game->GetTicksUntilFall();
+            int lockTicks = m_game->GetTicksUntilLock();
+            int repeatTicks = m_repeat.GetTicksUntilInput();
+            ticks = (lockTicks > 0 && lockTicks < ticks) ? lockTicks : ticks;
+            return (repeatTicks > 0 && repeatTicks < ticks) ? repeatTicks : ticks;
+        }
+        case STATE_GAME_OVER:
+            return GAME_OVER_TICKS - m_stateTicks;
+        default:
+            return 0;
+    }
 }
 
 /*
 ==================
-Update the view
+Ticks the game once with the input gathered since the last tick,
+recording it to the replay
 ==================
 */
-void GameController::UpdateView() {
-    m_view->Clear();
-    m_view->SetNextTetromino(m_game->GetNextShape(), m_game->GetNextColor());
-    m_view->SetStoredTetromino(m_game->GetStoredShape(), m_game->GetStoredColor());
-    m_view->DrawGUI(m_game->GetScore());
-    m_view->DrawBoard(m_game->GetBoard(), m_game->GetTetrominoColor());
-    m_view->Update();
+template <class BoardType>
+void GameController<BoardType>::StepGame() {
+    uint32_t input = m_input | m_repeat.Tick();
+    uint64_t hash = m_game->GetHash();
+    m_input = 0;
+
+    m_replay.RecordTick(m_game->GetTickCount(), input);
+    bool playing = m_game->Tick(input);
+    if (m_game->GetHash() != hash) {
+        m_dirty = true;
+    }
+    if (m_traceInterval > 0) {
+        m_trace.Record(m_game);
+    }
+    if (!playing) {
+        SetState(STATE_GAME_OVER);
+    }
 }
 
 /*
 ==================
-To be called when a GameOver condition is met, displays relevant GUI and
-then restarts the game
+Waits until the performance counter reaches a deadline, or an event
+arrives. The thread sleeps in SDL_WaitEventTimeout, which only
+times in whole milliseconds and often oversleeps, so it is woken
+SPIN_WAIT_MS early and the rest is spun out, still watching for events
+
+Parameters:
+>> deadline		Performance counter value to wait for, or NO_DEADLINE
+				to wait for an event however long it takes
 ==================
 */
-void GameController::GameOver() {
-    m_view->Clear();
-    m_view->DrawBoard(m_game->GetBoard(), m_game->GetTetrominoColor());
-    m_view->DrawGameOverText(m_game->GetScore());
-    m_view->Update();
-    SDL_Delay(4000);
+template <class BoardType>
+void GameController<BoardType>::WaitForEvents(uint64_t deadline) {
+    uint64_t frequency = SDL_GetPerformanceFrequency();
+    uint64_t spinLength = frequency * SPIN_WAIT_MS / 1000;
+    uint64_t now = SDL_GetPerformanceCounter();
+    uint64_t sleepStart = now;
+    bool woken = false;
 
+    if (deadline == NO_DEADLINE) {
+        SDL_WaitEvent(NULL);
+        woken = true;
+    }
+    while (!woken && now + spinLength < deadline) {
+        uint64_t sleepLength = deadline - now - spinLength;
+        woken = SDL_WaitEventTimeout(NULL, (int)(sleepLength * 1000 / frequency) + 1) != 0;
+        now = SDL_GetPerformanceCounter();
+    }
+    m_stats.sleepTime += SDL_GetPerformanceCounter() - sleepStart;
+
+    while (!woken && now < deadline) {
+        woken = SDL_PollEvent(NULL) != 0;
+        now = SDL_GetPerformanceCounter();
+    }
+}
+
+/*
+==================
+Update the view to show the current state
+==================
+*/
+template <class BoardType>
+void GameController<BoardType>::UpdateView() {
     m_view->Clear();
-    m_game->Reset();
-    m_view->DrawBoard(m_game->GetBoard(), m_game->GetTetrominoColor());
-    m_view->DrawStartText();
+
+    switch (m_state) {
+        case STATE_TITLE:
+        case STATE_COUNTDOWN:
+            m_view->DrawBoard(m_game->GetBoard(), m_game->GetTetromino(), NULL);
+            m_view->DrawStartText();
+            break;
+        case STATE_GAME_OVER:
+            m_view->DrawBoard(m_game->GetBoard(), m_game->GetTetromino(), NULL);
+            m_view->DrawGameOverText(m_game->GetScore());
+            break;
+        // The board is hidden while paused, so the game can't be planned ahead
+        case STATE_PAUSED:
+            m_view->SetStoredTetromino(m_game->GetStoredShape(), m_game->GetStoredColor());
+            m_view->DrawGUI(m_game->GetScore());
+            m_view->DrawPauseSymbol();
+            break;
+        default: {
+            m_view->SetStoredTetromino(m_game->GetStoredShape(), m_game->GetStoredColor());
+            m_view->DrawGUI(m_game->GetScore());
+
+            Tetromino ghost = m_game->GetGhostTetromino();
+            m_view->DrawBoard(m_game->GetBoard(), m_game->GetTetromino(), &ghost);
+            break;
+        }
+    }
     m_view->Update();
-    SDL_Delay(1000);
 }
 
 /*
@@ -164,7 +435,129 @@ void GameController::GameOver() {
 Delete objects on game quit
 ==================
 */
-void GameController::QuitGame() {
+template <class BoardType>
+void GameController<BoardType>::QuitGame() {
+    EndReplay();
+    if (m_printStats) {
+        PrintStats();
+    }
     delete(m_game);
     delete(m_view);
 }
+
+/*
+==================
+Prints how often the main loop woke and drew, and how much of the
+time it was awake - roughly the share of a core the game used,
+not counting the graphics driver
+==================
+*/
+template <class BoardType>
+void GameController<BoardType>::PrintStats() {
+    double frequency = (double)SDL_GetPerformanceFrequency();
+    double seconds = (SDL_GetPerformanceCounter() - m_stats.startCounter) / frequency;
+    double sleepSeconds = m_stats.sleepTime / frequency;
+    if (seconds <= 0.0) {
+        return;
+    }
+
+    printf("%.1f s: %llu passes (%.1f/s), %llu frames drawn (%.1f/s), awake %.1f%% of the time\n", seconds,
+           (unsigned long long)m_stats.passCount, m_stats.passCount / seconds,
+           (unsigned long long)m_stats.frameCount, m_stats.frameCount / seconds,
+           100.0 * (seconds - sleepSeconds) / seconds);
+}
+
+/*
+==================
+Starts recording a new game's inputs to a replay file. If the file
+can't be created the game is still played, just not recorded
+
+Parameters:
+>> seed		The seed the game was started with
+==================
+*/
+template <class BoardType>
+void GameController<BoardType>::StartReplay(uint64_t seed) {
+    snprintf(m_replayPath, sizeof(m_replayPath), REPLAY_PATH_FORMAT, (unsigned long long)seed);
+
+    ReplayHeader header;
+    header.seed = seed;
+    header.rulesetVersion = RULESET_VERSION;
+    header.boardWidth = BoardType::WIDTH;
+    header.boardHeight = BoardType::HEIGHT;
+    header.randomizerType = RANDOMIZER_BAG;
+    m_replay.Open(m_replayPath, header);
+
+    if (m_traceInterval > 0) {
+        m_trace.Reset(m_traceInterval, BoardType::WIDTH, BoardType::HEIGHT);
+        m_trace.Record(m_game);
+    }
+}
+
+/*
+==================
+Finishes the replay of the game being played, and saves its trace
+next to it, for DeterminismCheck to play the replay back against.
+Says so if either couldn't be written, e.g. because the disk is full
+==================
+*/
+template <class BoardType>
+void GameController<BoardType>::EndReplay() {
+    if (!m_replay.IsOpen()) {
+        return;
+    }
+    if (!m_replay.Close(m_game->GetTickCount())) {
+        printf("Could not write the replay %s\n", m_replayPath);
+    }
+
+    if (m_traceInterval > 0) {
+        char tracePath[REPLAY_PATH_SIZE + 8];
+        snprintf(tracePath, sizeof(tracePath), "%s%s", m_replayPath, TRACE_EXTENSION);
+        if (!m_trace.Save(tracePath)) {
+            printf("Could not write the trace %s\n", tracePath);
+        }
+    }
+}
+
+/*
+==================
+Runs a game on a board of the size chosen at startup. Each size has
+its own GameController, so the board size is only looked at here
+and never inside the game itself
+
+Parameters:
+>> options	Options chosen on the command line, including the
+			board size to play on (BOARD_STANDARD etc.)
+==================
+*/
+void RunGame(const GameOptions& options) {
+    switch (options.boardSize) {
+        case BOARD_NARROW: {
+            GameController<NarrowBoard> gameController(options);
+            gameController.StartGame();
+            break;
+        }
+        case BOARD_TALL: {
+            GameController<TallBoard> gameController(options);
+            gameController.StartGame();
+            break;
+        }
+        case BOARD_WIDE: {
+            GameController<WideBoard> gameController(options);
+            gameController.StartGame();
+            break;
+        }
+        default: {
+            GameController<StandardBoard> gameController(options);
+            gameController.StartGame();
+            break;
+        }
+    }
+}
+
+// ----- Board instantiations -----
+template class GameController<StandardBoard>;
+template class GameController<NarrowBoard>;
+template class GameController<TallBoard>;
+template class GameController<WideBoard>;
+// --------------------------------
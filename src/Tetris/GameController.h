@@ -8,30 +8,107 @@
 /*****************************************************************************************/
 
 // ------ Includes -----
+#include <stdio.h>
+#include <time.h>
+#include <vector>
 #include "Game.h"
 #include "View.h"
+#include "Replay.h"
+#include "Determinism.h"
+#include "InputRepeat.h"
+// ---------------------
+
+// ------ Constants -----
+constexpr auto REPLAY_PATH_FORMAT = "replay_%llu.trpl";		// Each game is recorded to a file named by its seed
+constexpr auto REPLAY_PATH_SIZE = 64;
+constexpr auto SIMULATION_RATE = TICK_RATE;		// Game ticks per second of real time
+constexpr auto RENDER_RATE = 60;					// Frames drawn per second
+constexpr auto MAX_TICKS_PER_FRAME = 8;			// Most ticks caught up on at once after a stall
+constexpr auto SPIN_WAIT_MS = 2;					// The end of each wait is spun, as sleeps overrun
+constexpr auto COUNTDOWN_TICKS = TICK_RATE;			// How long START GAME shows before play starts
+constexpr auto GAME_OVER_TICKS = TICK_RATE * 4;		// How long GAME OVER shows before the next game
+constexpr auto GAME_OVER_SKIP_TICKS = TICK_RATE / 2;	// GAME OVER can't be skipped until this has passed,
+													// so keys held as the game ended don't skip it
+constexpr auto NO_DEADLINE = ~0ull;					// For WaitForEvents, to wait for an event however long
+// ----------------------
+
+// ------ Enums --------
+
+// What the controller is doing - the screens before and after each game are states
+// of the main loop, so that it never stops to wait for them
+enum {
+	STATE_TITLE,		// Waiting for a key press to start the first game
+	STATE_COUNTDOWN,	// Showing START GAME before the game starts
+	STATE_PLAYING,
+	STATE_GAME_OVER,	// Showing the final score before the next game
+	STATE_PAUSED		// Waiting for P to be pressed again
+};
+// ---------------------
+
+// Options chosen on the command line
+struct GameOptions {
+	int boardSize;			// BOARD_ value
+	int traceInterval;		// Ticks between determinism trace checkpoints; 0 for no trace
+	bool printStats;		// Whether to print how busy the main loop was on quit
+	int dasTicks;			// Ticks a move key is held before it repeats
+	int arrTicks;			// Ticks between repeats; 0 shifts straight to the wall
+};
+
+// An event waiting to be handled, with the performance counter value it arrived at
+struct QueuedEvent {
+	SDL_Event event;
+	uint64_t counter;
+};
+
+// How the main loop has spent its time, to show how much it sleeps
+struct LoopStats {
+	uint64_t startCounter;		// Performance counter when the loop started
+	uint64_t sleepTime;			// Performance counter time spent asleep
+	uint64_t passCount;			// Passes of the loop
+	uint64_t frameCount;		// Frames drawn
+};
+
+// ------ Functions ----
+void RunGame(const GameOptions& options);
 // ---------------------
 
 #pragma once
+template <class BoardType>
 class GameController
 {
 	public:
-		GameController();
+		GameController(const GameOptions& options);
 		void StartGame();
 
 	private:
-		void GameOver();
+		void PollEvents();
+		void HandleEvents(uint64_t before);
+		void HandleKey(SDL_Keycode key, bool down);
+		void SetState(int state);
+		void StepState();
+		int GetTicksUntilWake();
+		void StepGame();
+		void WaitForEvents(uint64_t deadline);
 		void UpdateView();
 		void QuitGame();
-		Game* m_game;
+		void PrintStats();
+		void StartReplay(uint64_t seed);
+		void EndReplay();
+		Game<BoardType>* m_game;
 		View* m_view;
-		bool m_canReleaseStoredTet;		// True when it is valid for a Tetromino to be released
-		bool m_canStoreTet;				// True when it is valid for a Tetromino to be stored
-
-		unsigned long m_fallRate;		// Number of ms between Tetromino falling
-
-		unsigned long m_fallTime1;		// m_fallTime2 - m_fallTime1 gives the number of ms
-		unsigned long m_fallTime2;		// since the Tetromino last fell
+		ReplayWriter m_replay;		// Inputs of the game being played
+		DeterminismTrace m_trace;	// State of the game being played, if traceInterval > 0
+		int m_traceInterval;
+		char m_replayPath[REPLAY_PATH_SIZE];
+		uint32_t m_input;			// Keys pressed since the last tick, other than the ones that repeat
+		InputRepeat m_repeat;		// Keys that repeat while held
+		std::vector<QueuedEvent> m_events;
+		bool m_keyPressed;			// Whether any key was pressed since the last tick
+		int m_state;				// STATE_ value
+		int m_stateTicks;			// Ticks spent in the current state
+		bool m_dirty;				// Whether anything has changed since the last frame was drawn
+		bool m_printStats;
+		LoopStats m_stats;
 
 		bool quit;
 };
@@ -0,0 +1,48 @@
+/*****************************************************************************************
+/* File: GameState.h
+/* Description: Plain structs holding the whole state of a game, so that it can be saved
+/*				and restored with a memcpy
+/*
+/* Rachel Pearson 2022
+/*
+/*****************************************************************************************/
+
+// ------ Includes -----
+#include <stdint.h>
+#include <type_traits>
+#include "Board.h"
+#include "Tetromino.h"
+#include "Random.h"
+#include "Randomizer.h"
+// ---------------------
+
+#pragma once
+
+// Everything about a game apart from its board
+struct GameVariables {
+	Tetromino tetromino;	// The player Tetromino
+	PieceQueue pieceQueue;	// Upcoming Tetrominoes, next one first
+	Randomizer randomizer;	// Picks the shapes that go into the queue
+	int score;				// Current score
+	int storedShape;		// Stored Tetromino's shape
+	int storedColor;		// Stored Tetromino's color
+	bool canStore;			// True when it is valid for a Tetromino to be stored
+	bool canRelease;		// True when it is valid for the stored Tetromino to be released
+	bool gameOver;			// True once a Tetromino could not be placed
+	int fallTimer;			// Ticks since the player Tetromino last fell
+	int32_t lockTimer;		// Ticks the player Tetromino has rested on the stack for
+	int32_t lockResets;		// Times the lock delay has been restarted since lowestY last changed
+	int32_t lowestY;		// Lowest row the player Tetromino's pivot has reached
+	uint32_t tickCount;		// Ticks the game has run for
+	int pieceCount;			// Tetrominoes placed
+	Random random;			// The game's own random numbers, so they are saved with it
+};
+
+// The whole state of a game - fixed in size and safe to copy with memcpy
+template <class BoardType>
+struct GameState {
+	BoardType board;
+	GameVariables variables;
+
+	static_assert(std::is_trivially_copyable<BoardType>::value, "Boards must be memcpy-able");
+};
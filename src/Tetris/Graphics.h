@@ -48,6 +48,7 @@ class Graphics
 		Color WHITE = { 255, 255, 255 };
 		Color RED = { 255, 0, 0 };
 		Color BLUE = { 0, 0, 255 };
+		Color GREY = { 100, 100, 100 };
 
 	private:
 		void LoadSprites();
@@ -0,0 +1,155 @@
+/*****************************************************************************************
+/* File: InputRepeat.cpp
+/* Description: Turns the move keys being held down into the inputs for each tick - a
+/*				key moves once when pressed, then again after the delayed auto shift
+/*				(DAS), then once every auto repeat rate (ARR) ticks. All timing is
+/*				counted in game ticks, so it doesn't depend on the OS key repeat rate.
+/*				Soft drop doesn't repeat; it is given on every tick that down is held
+/*
+/* Rachel Pearson 2022
+/*
+/*****************************************************************************************/
+
+#include "InputRepeat.h"
+
+// The keys that are tracked while held
+constexpr uint32_t REPEAT_INPUTS = INPUT_LEFT | INPUT_RIGHT | INPUT_SOFT_DROP;
+
+/*
+==================
+Constructor
+==================
+*/
+InputRepeat::InputRepeat() {
+	SetTiming(DEFAULT_DAS_TICKS, DEFAULT_ARR_TICKS);
+	ReleaseAll();
+}
+
+/*
+==================
+Sets how quickly held left/right keys repeat
+
+Parameters:
+>> dasTicks		Ticks a key is held after its first move before it
+				starts repeating
+>> arrTicks		Ticks between repeats; 0 moves the Tetromino straight
+				to the wall every tick once DAS is charged
+==================
+*/
+void InputRepeat::SetTiming(int dasTicks, int arrTicks) {
+	m_dasTicks = (dasTicks > 1) ? dasTicks : 1;
+	m_arrTicks = (arrTicks > 0) ? arrTicks : 0;
+}
+
+/*
+==================
+To be called when a key goes down. The next tick moves once even if
+the key is let go before it, so quick taps are never lost
+
+Parameters:
+>> input	The INPUT_ bit of the key
+==================
+*/
+void InputRepeat::Press(uint32_t input) {
+	if ((input & REPEAT_INPUTS) == 0 || (m_held & input) != 0) {
+		return;
+	}
+	m_held |= input;
+	m_pressed |= input;
+
+	// The last direction pressed wins
+	if (input != INPUT_SOFT_DROP) {
+		m_shiftInput = input;
+		m_shiftTicks = 0;
+	}
+}
+
+/*
+==================
+To be called when a key comes up. If the other direction is still
+held it takes over, charging DAS from the start without moving
+
+Parameters:
+>> input	The INPUT_ bit of the key
+==================
+*/
+void InputRepeat::Release(uint32_t input) {
+	m_held &= ~input;
+
+	if (input == m_shiftInput) {
+		uint32_t other = (input == INPUT_LEFT) ? INPUT_RIGHT : INPUT_LEFT;
+		m_shiftInput = (m_held & other) ? other : 0;
+		m_shiftTicks = 0;
+	}
+}
+
+/*
+==================
+Forgets every key, e.g. when the window loses focus and won't be
+told about keys coming up
+==================
+*/
+void InputRepeat::ReleaseAll() {
+	m_held = 0;
+	m_pressed = 0;
+	m_shiftInput = 0;
+	m_shiftTicks = 0;
+}
+
+/*
+==================
+Moves on one tick
+
+Returns:
+>> Mask of the INPUT_ bits for this tick - the keys pressed since
+   the last tick, plus any repeats that have come due, plus soft
+   drop while down is held
+==================
+*/
+uint32_t InputRepeat::Tick() {
+	uint32_t input = m_pressed | (m_held & INPUT_SOFT_DROP);
+	m_pressed = 0;
+
+	// The tick a key is pressed on is its first move, so holding only counts after it
+	if (m_shiftInput != 0 && (input & m_shiftInput) == 0) {
+		m_shiftTicks++;
+		if (m_shiftTicks >= m_dasTicks) {
+			if (m_arrTicks == 0) {
+				input |= (m_shiftInput == INPUT_LEFT) ? INPUT_LEFT_WALL : INPUT_RIGHT_WALL;
+			}
+			else if ((m_shiftTicks - m_dasTicks) % m_arrTicks == 0) {
+				input |= m_shiftInput;
+			}
+		}
+	}
+	return input;
+}
+
+/*
+==================
+Get the number of ticks until Tick next gives an input, so that the
+game loop knows when it has to wake
+
+Returns:
+>> Number of ticks, or 0 if nothing happens until a key is pressed
+==================
+*/
+int InputRepeat::GetTicksUntilInput() {
+	if (m_pressed != 0 || (m_held & INPUT_SOFT_DROP)) {
+		return 1;
+	}
+
+	int ticks = 0;
+	if (m_shiftInput != 0) {
+		if (m_shiftTicks + 1 < m_dasTicks) {
+			ticks = m_dasTicks - m_shiftTicks;
+		}
+		else if (m_arrTicks == 0) {
+			ticks = 1;
+		}
+		else {
+			ticks = 1 + (m_arrTicks - (m_shiftTicks + 1 - m_dasTicks) % m_arrTicks) % m_arrTicks;
+		}
+	}
+	return ticks;
+}
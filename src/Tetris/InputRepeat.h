@@ -0,0 +1,42 @@
+/*****************************************************************************************
+/* File: InputRepeat.h
+/* Description: Turns the move keys being held down into the inputs for each tick - a
+/*				key moves once when pressed, then again after the delayed auto shift
+/*				(DAS), then once every auto repeat rate (ARR) ticks. All timing is
+/*				counted in game ticks, so it doesn't depend on the OS key repeat rate.
+/*				Soft drop doesn't repeat; it is given on every tick that down is held
+/*
+/* Rachel Pearson 2022
+/*
+/*****************************************************************************************/
+
+// ------ Includes -----
+#include <stdint.h>
+#include "Game.h"
+// ---------------------
+
+// ------ Constants -----
+constexpr auto DEFAULT_DAS_TICKS = 10;			// About 167 ms at 60 ticks per second
+constexpr auto DEFAULT_ARR_TICKS = 2;			// About 33 ms at 60 ticks per second
+// ----------------------
+
+#pragma once
+class InputRepeat
+{
+	public:
+		InputRepeat();
+		void SetTiming(int dasTicks, int arrTicks);
+		void Press(uint32_t input);
+		void Release(uint32_t input);
+		void ReleaseAll();
+		uint32_t Tick();
+		int GetTicksUntilInput();
+
+	private:
+		int m_dasTicks;
+		int m_arrTicks;				// 0 shifts straight to the wall once DAS is charged
+		uint32_t m_held;			// INPUT_ bits of the keys held down
+		uint32_t m_pressed;			// INPUT_ bits of the presses the next tick hasn't had yet
+		uint32_t m_shiftInput;		// INPUT_LEFT or INPUT_RIGHT being auto shifted, or 0
+		int m_shiftTicks;			// Ticks m_shiftInput has been held for
+};
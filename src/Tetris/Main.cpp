@@ -1,17 +1,70 @@
 /*****************************************************************************************
 /* File: Main.cpp
-/* Description: The Main class - simply creates a GameController and starts the game
+/* Description: The Main class - picks the board size from the command line, then creates
+/*				a GameController for it and starts the game
 /*
 /* Rachel Pearson 2022
 /*
 /*****************************************************************************************/
 
-#include <windows.h>
+#include <stdlib.h>
+#include <string.h>
 #include "GameController.h"
 
-int main() {
-	GameController gameController;
-	gameController.StartGame();
+/*
+==================
+Converts a time in milliseconds to the nearest number of game ticks
+==================
+*/
+static int MsToTicks(int ms) {
+	return (ms * TICK_RATE + 500) / 1000;
+}
+
+/*
+==================
+Reads the board size from the command line ("narrow", "tall" or
+"wide"), defaulting to the standard board. "--trace [interval]"
+also saves a determinism trace next to each replay, "--stats"
+prints how busy the main loop was when the game is closed, and
+"--das <ms>" and "--arr <ms>" set how held move keys repeat
+==================
+*/
+int main(int argc, char* argv[]) {
+	GameOptions options;
+	options.boardSize = BOARD_STANDARD;
+	options.traceInterval = 0;
+	options.printStats = false;
+	options.dasTicks = DEFAULT_DAS_TICKS;
+	options.arrTicks = DEFAULT_ARR_TICKS;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "narrow") == 0) {
+			options.boardSize = BOARD_NARROW;
+		}
+		else if (strcmp(argv[i], "tall") == 0) {
+			options.boardSize = BOARD_TALL;
+		}
+		else if (strcmp(argv[i], "wide") == 0) {
+			options.boardSize = BOARD_WIDE;
+		}
+		else if (strcmp(argv[i], "--trace") == 0) {
+			options.traceInterval = DEFAULT_TRACE_INTERVAL;
+			if (i + 1 < argc && atoi(argv[i + 1]) > 0) {
+				options.traceInterval = atoi(argv[++i]);
+			}
+		}
+		else if (strcmp(argv[i], "--stats") == 0) {
+			options.printStats = true;
+		}
+		else if (strcmp(argv[i], "--das") == 0 && i + 1 < argc) {
+			options.dasTicks = MsToTicks(atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "--arr") == 0 && i + 1 < argc) {
+			options.arrTicks = MsToTicks(atoi(argv[++i]));
+		}
+	}
+
+	RunGame(options);
 
 	return 0;
-}
\ No newline at end of file
+}
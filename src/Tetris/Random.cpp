@@ -0,0 +1,72 @@
+/*****************************************************************************************
+/* File: Random.cpp
+/* Description: A small seedable random number generator (PCG32). Each game owns one by
+/*				value in its state, so games never share random state, and a game with the
+/*				same seed gives the same numbers on every platform and thread
+/*
+/* Rachel Pearson 2022
+/*
+/*****************************************************************************************/
+
+#include "Random.h"
+
+/*
+==================
+Seeds the generator; the seed picks both the starting state and
+the stream, so different seeds give unrelated sequences
+
+Parameters:
+>> seed		Any 64-bit value
+==================
+*/
+void Random::Seed(uint64_t seed) {
+	m_state = 0;
+	m_increment = (seed << 1) | 1;
+	Next();
+	m_state += seed;
+	Next();
+}
+
+/*
+==================
+Get the next random 32-bit value - steps the 64-bit state, then
+permutes its top bits with a xorshift and a random rotation
+==================
+*/
+uint32_t Random::Next() {
+	uint64_t oldState = m_state;
+	m_state = oldState * 6364136223846793005ull + m_increment;
+
+	uint32_t xorShifted = (uint32_t)(((oldState >> 18) ^ oldState) >> 27);
+	uint32_t rotation = (uint32_t)(oldState >> 59);
+	return (xorShifted >> rotation) | (xorShifted << ((0u - rotation) & 31));
+}
+
+/*
+==================
+Get a value that changes whenever the generator's state does, for
+checking that two runs of a game agree
+==================
+*/
+uint64_t Random::GetHash() {
+	return m_state ^ (m_increment * 0x9E3779B97F4A7C15ull);
+}
+
+/*
+==================
+Get a random integer from 0 to bound-1, with no bias towards any
+of them - values from the uneven remainder at the bottom of the
+range are thrown away
+
+Parameters:
+>> bound	Number of possible values (at least 1)
+==================
+*/
+int Random::NextInt(int bound) {
+	uint32_t threshold = (0u - (uint32_t)bound) % (uint32_t)bound;
+	uint32_t value = Next();
+	while (value < threshold) {
+		value = Next();
+	}
+	return (int)(value % (uint32_t)bound);
+}
@@ -0,0 +1,34 @@
+/*****************************************************************************************
+/* File: Random.h
+/* Description: A small seedable random number generator (PCG32). Each game owns one by
+/*				value in its state, so games never share random state, and a game with the
+/*				same seed gives the same numbers on every platform and thread
+/*
+/* Rachel Pearson 2022
+/*
+/*****************************************************************************************/
+
+// ------ Includes -----
+#include <stdint.h>
+#include <type_traits>
+// ---------------------
+
+#pragma once
+
+// A plain value type, so that it can be saved and restored with the rest of the game state
+class Random
+{
+public:
+	Random() = default;
+	void Seed(uint64_t seed);
+	uint32_t Next();
+	int NextInt(int bound);
+	uint64_t GetHash();
+
+private:
+	uint64_t m_state;
+	uint64_t m_increment;		// Picks the stream; always odd
+};
+
+static_assert(std::is_trivial<Random>::value && std::is_standard_layout<Random>::value,
+			  "Random must stay a plain value type");
@@ -0,0 +1,192 @@
+/*****************************************************************************************
+/* File: Randomizer.cpp
+/* Description: Picks the shapes of upcoming Tetrominoes (7-bag, memoryless or history
+/*				based), and the fixed-size queue of upcoming Tetrominoes it feeds. Both are
+/*				plain value types, so they are saved and restored with the game state
+/*
+/* Rachel Pearson 2022
+/*
+/*****************************************************************************************/
+
+#include "Randomizer.h"
+
+/*
+==================
+Starts the randomizer afresh - an empty bag, and a history that
+makes S and Z unlikely to come first
+
+Parameters:
+>> type		RANDOMIZER_BAG, RANDOMIZER_MEMORYLESS or
+			RANDOMIZER_HISTORY
+==================
+*/
+void Randomizer::Reset(int type) {
+	m_type = (int8_t)type;
+
+	for (int i = 0; i < TET_SHAPE_COUNT; i++) {
+		m_bag[i] = (int8_t)i;
+	}
+	m_bagIndex = TET_SHAPE_COUNT;
+
+	m_history[0] = Z;
+	m_history[1] = Z;
+	m_history[2] = S;
+	m_history[3] = S;
+}
+
+int Randomizer::GetType() {
+	return m_type;
+}
+
+/*
+==================
+Get the whole state of the randomizer packed into one value, for
+checking that two runs of a game agree. Every field fits in 3 bits,
+so no two states give the same value
+==================
+*/
+uint64_t Randomizer::GetHash() {
+	uint64_t hash = (uint64_t)m_type;
+
+	for (int i = 0; i < TET_SHAPE_COUNT; i++) {
+		hash = (hash << 3) | (uint64_t)m_bag[i];
+	}
+	hash = (hash << 3) | (uint64_t)m_bagIndex;
+	for (int i = 0; i < HISTORY_SIZE; i++) {
+		hash = (hash << 3) | (uint64_t)m_history[i];
+	}
+	return hash;
+}
+
+/*
+==================
+Get the shape of the next Tetromino
+
+Parameters:
+>> random	The game's random number generator
+==================
+*/
+int Randomizer::NextShape(Random* random) {
+	switch (m_type) {
+		case RANDOMIZER_MEMORYLESS:
+			return random->NextInt(TET_SHAPE_COUNT);
+		case RANDOMIZER_HISTORY:
+			return NextHistoryShape(random);
+		default:
+			return NextBagShape(random);
+	}
+}
+
+/*
+==================
+Deals the next shape from the bag, shuffling all 7 shapes into a
+new bag (Fisher-Yates) once the last one has been dealt
+==================
+*/
+int Randomizer::NextBagShape(Random* random) {
+	if (m_bagIndex == TET_SHAPE_COUNT) {
+		for (int i = TET_SHAPE_COUNT - 1; i > 0; i--) {
+			int j = random->NextInt(i + 1);
+			int8_t shape = m_bag[i];
+			m_bag[i] = m_bag[j];
+			m_bag[j] = shape;
+		}
+		m_bagIndex = 0;
+	}
+	return m_bag[m_bagIndex++];
+}
+
+/*
+==================
+Rolls a shape, rolling again (up to HISTORY_ROLLS times in all) if
+it is one of the last few shapes given, then remembers it
+==================
+*/
+int Randomizer::NextHistoryShape(Random* random) {
+	int shape = 0;
+
+	for (int roll = 0; roll < HISTORY_ROLLS; roll++) {
+		shape = random->NextInt(TET_SHAPE_COUNT);
+
+		bool isRecent = false;
+		for (int i = 0; i < HISTORY_SIZE; i++) {
+			if (m_history[i] == shape) {
+				isRecent = true;
+			}
+		}
+		if (!isRecent) {
+			break;
+		}
+	}
+
+	for (int i = HISTORY_SIZE - 1; i > 0; i--) {
+		m_history[i] = m_history[i - 1];
+	}
+	m_history[0] = (int8_t)shape;
+	return shape;
+}
+
+/*
+==================
+Empties the queue
+==================
+*/
+void PieceQueue::Clear() {
+	m_head = 0;
+	m_count = 0;
+}
+
+/*
+==================
+Adds a Tetromino to the back of the queue, which must not be full
+
+Parameters:
+>> shape	Shape of the Tetromino
+>> color	Color of the Tetromino
+==================
+*/
+void PieceQueue::Push(int shape, int color) {
+	int tail = (m_head + m_count) & (PIECE_QUEUE_CAPACITY - 1);
+	m_shapes[tail] = (int8_t)shape;
+	m_colors[tail] = (int8_t)color;
+	m_count++;
+}
+
+/*
+==================
+Removes the Tetromino at the front of the queue, which must not be
+empty
+==================
+*/
+void PieceQueue::Pop() {
+	m_head = (m_head + 1) & (PIECE_QUEUE_CAPACITY - 1);
+	m_count--;
+}
+
+int PieceQueue::GetCount() {
+	return m_count;
+}
+
+/*
+==================
+Get the shape of an upcoming Tetromino
+
+Parameters:
+>> index	How far back in the queue it is; 0 is the next one
+==================
+*/
+int PieceQueue::GetShape(int index) {
+	return m_shapes[(m_head + index) & (PIECE_QUEUE_CAPACITY - 1)];
+}
+
+/*
+==================
+Get the color of an upcoming Tetromino
+
+Parameters:
+>> index	How far back in the queue it is; 0 is the next one
+==================
+*/
+int PieceQueue::GetColor(int index) {
+	return m_colors[(m_head + index) & (PIECE_QUEUE_CAPACITY - 1)];
+}
@@ -0,0 +1,81 @@
+/*****************************************************************************************
+/* File: Randomizer.h
+/* Description: Picks the shapes of upcoming Tetrominoes (7-bag, memoryless or history
+/*				based), and the fixed-size queue of upcoming Tetrominoes it feeds. Both are
+/*				plain value types, so they are saved and restored with the game state
+/*
+/* Rachel Pearson 2022
+/*
+/*****************************************************************************************/
+
+// ------ Includes -----
+#include <stdint.h>
+#include <type_traits>
+#include "Tetromino.h"
+#include "Random.h"
+// ---------------------
+
+// ------ Constants -----
+constexpr auto PIECE_QUEUE_CAPACITY = 8;	// Upcoming Tetrominoes kept; must be a power of 2
+constexpr auto PREVIEW_COUNT = 5;			// Upcoming Tetrominoes shown to the player
+
+constexpr auto HISTORY_SIZE = 4;			// Shapes remembered by the history randomizer
+constexpr auto HISTORY_ROLLS = 6;			// Tries it makes at a shape not in its history
+// ----------------------
+
+// ------ Enums --------
+enum {
+	RANDOMIZER_BAG,			// Deals out all 7 shapes in a random order, then reshuffles
+	RANDOMIZER_MEMORYLESS,	// Every shape is equally likely every time
+	RANDOMIZER_HISTORY,		// Rerolls shapes that came up recently
+	RANDOMIZER_COUNT
+};
+// ---------------------
+
+#pragma once
+
+// A randomizer of any type; the type is a value rather than a subclass, so that
+// a randomizer can be copied along with the rest of the game state
+class Randomizer
+{
+public:
+	Randomizer() = default;
+	void Reset(int type);
+	int GetType();
+	uint64_t GetHash();
+	int NextShape(Random* random);
+
+private:
+	int NextBagShape(Random* random);
+	int NextHistoryShape(Random* random);
+
+	int8_t m_type;
+	int8_t m_bag[TET_SHAPE_COUNT];			// Shapes in the current bag, in the order dealt
+	int8_t m_bagIndex;						// Next shape to deal from the bag
+	int8_t m_history[HISTORY_SIZE];			// Most recent shapes, newest first
+};
+
+// Ring buffer of upcoming Tetrominoes, read in place by the game, the view and bots
+class PieceQueue
+{
+public:
+	PieceQueue() = default;
+	void Clear();
+	void Push(int shape, int color);
+	void Pop();
+	int GetCount();
+	int GetShape(int index);
+	int GetColor(int index);
+
+private:
+	int8_t m_shapes[PIECE_QUEUE_CAPACITY];
+	int8_t m_colors[PIECE_QUEUE_CAPACITY];
+	uint8_t m_head;			// Index of the next Tetromino
+	uint8_t m_count;
+};
+
+static_assert((PIECE_QUEUE_CAPACITY & (PIECE_QUEUE_CAPACITY - 1)) == 0,
+			  "The piece queue capacity must be a power of 2");
+static_assert(PREVIEW_COUNT <= PIECE_QUEUE_CAPACITY, "Cannot preview more than the queue holds");
+static_assert(std::is_trivial<Randomizer>::value && std::is_trivial<PieceQueue>::value,
+			  "Randomizer and PieceQueue must stay plain value types");
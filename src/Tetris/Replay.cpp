@@ -0,0 +1,414 @@
+/*****************************************************************************************
+/* File: Replay.cpp
+/* Description: Records the inputs of a game to a compact binary file, and reads them
+/*				back so that the game can be played again exactly. Only the seed, the
+/*				rules and the ticks that had inputs are stored - the game's rules are
+/*				deterministic, so that is all it takes to rebuild everything else
+/*
+/* Rachel Pearson 2022
+/*
+/*****************************************************************************************/
+
+#include "Replay.h"
+
+// ------ ReplayWriter -----
+
+/*
+==================
+Constructor
+==================
+*/
+ReplayWriter::ReplayWriter() {
+	m_file = NULL;
+	m_bufferUsed = 0;
+	m_lastTick = 0;
+	m_failed = false;
+}
+
+/*
+==================
+Destructor - writes out anything still buffered. A replay that
+was never closed has no end record, and is played up to its last
+input
+==================
+*/
+ReplayWriter::~ReplayWriter() {
+	if (m_file != NULL) {
+		Flush();
+		fclose(m_file);
+	}
+}
+
+/*
+==================
+Creates the replay file and writes its header. Any replay already
+being written is finished first
+
+Parameters:
+>> path		File to write to; replaced if it exists
+>> header	Seed and rules of the game being recorded
+
+Returns:
+>> True if the file could be created
+==================
+*/
+bool ReplayWriter::Open(const char* path, const ReplayHeader& header) {
+	// The end record goes after the last input recorded, so that it is played
+	if (m_file != NULL) {
+		Close(m_lastTick + 1);
+	}
+
+	m_file = fopen(path, "wb");
+	if (m_file == NULL) {
+		return false;
+	}
+	m_bufferUsed = 0;
+	m_lastTick = 0;
+	m_failed = false;
+
+	uint32_t magic = REPLAY_MAGIC;
+	for (int i = 0; i < 4; i++) {
+		WriteByte((uint8_t)(magic >> (i * 8)));
+	}
+	WriteByte((uint8_t)REPLAY_FORMAT_VERSION);
+	WriteByte((uint8_t)(REPLAY_FORMAT_VERSION >> 8));
+	WriteByte((uint8_t)header.rulesetVersion);
+	WriteByte((uint8_t)(header.rulesetVersion >> 8));
+	WriteByte((uint8_t)header.boardWidth);
+	WriteByte((uint8_t)header.boardHeight);
+	WriteByte((uint8_t)header.randomizerType);
+	WriteByte(0);
+	for (int i = 0; i < 8; i++) {
+		WriteByte((uint8_t)(header.seed >> (i * 8)));
+	}
+	return true;
+}
+
+bool ReplayWriter::IsOpen() {
+	return m_file != NULL;
+}
+
+/*
+==================
+Records the inputs pressed on one tick; ticks with no inputs
+don't need recording. Ticks must be recorded in order
+
+Parameters:
+>> tick		Ticks the game had run before this one
+>> input	Mask of the INPUT_ bits pressed
+==================
+*/
+void ReplayWriter::RecordTick(uint32_t tick, uint32_t input) {
+	if (m_file == NULL || input == 0) {
+		return;
+	}
+	WriteVarint(tick - m_lastTick);
+	WriteVarint(input);
+	m_lastTick = tick;
+}
+
+/*
+==================
+Writes the end record and closes the file
+
+Parameters:
+>> tickCount	Ticks the game ran for in all
+
+Returns:
+>> True if the whole replay was written, false if any write
+   failed (e.g. the disk was full) and the file is incomplete
+==================
+*/
+bool ReplayWriter::Close(uint32_t tickCount) {
+	if (m_file == NULL) {
+		return false;
+	}
+	WriteVarint(tickCount - m_lastTick);
+	WriteVarint(0);
+	Flush();
+
+	bool written = (fclose(m_file) == 0) && !m_failed;
+	m_file = NULL;
+	return written;
+}
+
+void ReplayWriter::WriteByte(uint8_t value) {
+	if (m_bufferUsed == REPLAY_BUFFER_SIZE) {
+		Flush();
+	}
+	m_buffer[m_bufferUsed++] = value;
+}
+
+void ReplayWriter::WriteVarint(uint64_t value) {
+	while (value >= 0x80) {
+		WriteByte((uint8_t)(value | 0x80));
+		value >>= 7;
+	}
+	WriteByte((uint8_t)value);
+}
+
+void ReplayWriter::Flush() {
+	if (m_bufferUsed > 0) {
+		if (fwrite(m_buffer, 1, m_bufferUsed, m_file) != (size_t)m_bufferUsed) {
+			m_failed = true;
+		}
+		m_bufferUsed = 0;
+	}
+}
+
+// -------------------------
+
+// ------ ReplayReader -----
+
+/*
+==================
+Constructor
+==================
+*/
+ReplayReader::ReplayReader() {
+	m_data = NULL;
+	m_size = 0;
+	m_header = {};
+	m_tickCount = 0;
+	m_complete = false;
+	m_cursor = {};
+}
+
+/*
+==================
+Loads a replay file into memory and opens it
+
+Parameters:
+>> path		File to read
+
+Returns:
+>> True if the file was a replay this version can read
+==================
+*/
+bool ReplayReader::Open(const char* path) {
+	FILE* file = fopen(path, "rb");
+	if (file == NULL) {
+		return false;
+	}
+	m_file.clear();
+	uint8_t chunk[REPLAY_BUFFER_SIZE];
+	size_t read;
+	while ((read = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+		m_file.insert(m_file.end(), chunk, chunk + read);
+	}
+	fclose(file);
+
+	return OpenMemory(m_file.data(), m_file.size());
+}
+
+/*
+==================
+Opens a replay that is already in memory, without copying it. Its
+header is checked, then its records are read through once to find
+how long the game ran for. Playback starts from the first tick
+
+Parameters:
+>> data		The replay, as laid out in a replay file
+>> size		Size of the replay in bytes
+
+Returns:
+>> True if it was a replay this version can read
+==================
+*/
+bool ReplayReader::OpenMemory(const uint8_t* data, size_t size) {
+	m_data = data;
+	m_size = size;
+	if (!ReadHeader()) {
+		return false;
+	}
+
+	// Find the end record; without one, the game is played up to its last input
+	size_t position = REPLAY_HEADER_SIZE;
+	uint64_t tick = 0;
+	uint64_t delta;
+	uint64_t input;
+	m_complete = false;
+	m_tickCount = 0;
+	while (ReadVarint(&position, &delta) && ReadVarint(&position, &input)) {
+		tick += delta;
+		if (input == 0) {
+			m_complete = true;
+			m_tickCount = (uint32_t)tick;
+			break;
+		}
+		m_tickCount = (uint32_t)tick + 1;
+	}
+
+	Rewind();
+	return true;
+}
+
+/*
+==================
+Opens a replay that is already in memory, and whose length is
+already known (from an archive's index, say), so that opening it
+doesn't need to read through its records
+
+Parameters:
+>> data			The replay, as laid out in a replay file
+>> size			Size of the replay in bytes
+>> tickCount	Ticks the game ran for
+>> complete		Whether the replay has its end record
+
+Returns:
+>> True if it was a replay this version can read
+==================
+*/
+bool ReplayReader::OpenMemory(const uint8_t* data, size_t size, uint32_t tickCount, bool complete) {
+	m_data = data;
+	m_size = size;
+	if (!ReadHeader()) {
+		return false;
+	}
+	m_tickCount = tickCount;
+	m_complete = complete;
+
+	Rewind();
+	return true;
+}
+
+// ------ Getters & Setters -----
+const ReplayHeader& ReplayReader::GetHeader() {
+	return m_header;
+}
+
+const uint8_t* ReplayReader::GetData() {
+	return m_data;
+}
+
+size_t ReplayReader::GetSize() {
+	return m_size;
+}
+
+uint32_t ReplayReader::GetTickCount() {
+	return m_tickCount;
+}
+
+bool ReplayReader::IsComplete() {
+	return m_complete;
+}
+
+ReplayCursor ReplayReader::GetCursor() {
+	return m_cursor;
+}
+
+void ReplayReader::SetCursor(const ReplayCursor& cursor) {
+	m_cursor = cursor;
+}
+// ------------------------------
+
+/*
+==================
+Goes back to the first tick of the replay
+==================
+*/
+void ReplayReader::Rewind() {
+	m_cursor.tick = 0;
+	m_cursor.position = REPLAY_HEADER_SIZE;
+	m_cursor.eventTick = 0;
+	ReadEvent();
+}
+
+/*
+==================
+Gets the inputs for the next tick of the game
+
+Parameters:
+>> input	Set to the mask of INPUT_ bits pressed
+
+Returns:
+>> False once every tick of the game has been handed out
+==================
+*/
+bool ReplayReader::NextTick(uint32_t* input) {
+	if (m_cursor.tick >= m_tickCount) {
+		return false;
+	}
+	*input = 0;
+	if (m_cursor.tick == m_cursor.eventTick && m_cursor.eventInput != 0) {
+		*input = m_cursor.eventInput;
+		ReadEvent();
+	}
+	m_cursor.tick++;
+	return true;
+}
+
+/*
+==================
+Checks the replay's header and reads it into m_header
+
+Returns:
+>> False if it isn't a replay this version can read
+==================
+*/
+bool ReplayReader::ReadHeader() {
+	if (m_size < REPLAY_HEADER_SIZE) {
+		return false;
+	}
+	const uint8_t* data = m_data;
+	uint32_t magic = data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t)data[3] << 24);
+	int formatVersion = data[4] | (data[5] << 8);
+	if (magic != (uint32_t)REPLAY_MAGIC || formatVersion != REPLAY_FORMAT_VERSION) {
+		return false;
+	}
+	m_header.rulesetVersion = data[6] | (data[7] << 8);
+	m_header.boardWidth = data[8];
+	m_header.boardHeight = data[9];
+	m_header.randomizerType = data[10];
+	m_header.seed = 0;
+	for (int i = 0; i < 8; i++) {
+		m_header.seed |= (uint64_t)data[12 + i] << (i * 8);
+	}
+	return true;
+}
+
+/*
+==================
+Reads a varint from the replay
+
+Parameters:
+>> position		Byte to read from; moved past the varint
+>> value		Set to the value read
+
+Returns:
+>> False if the replay ends part way through
+==================
+*/
+bool ReplayReader::ReadVarint(size_t* position, uint64_t* value) {
+	*value = 0;
+	for (int shift = 0; shift < 64 && *position < m_size; shift += 7) {
+		uint8_t byte = m_data[(*position)++];
+		*value |= (uint64_t)(byte & 0x7F) << shift;
+		if ((byte & 0x80) == 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/*
+==================
+Reads the next record into the cursor's eventTick and eventInput;
+the end of the replay counts as an end record
+==================
+*/
+void ReplayReader::ReadEvent() {
+	size_t position = m_cursor.position;
+	uint64_t delta;
+	uint64_t input;
+
+	if (ReadVarint(&position, &delta) && ReadVarint(&position, &input)) {
+		m_cursor.eventTick += (uint32_t)delta;
+		m_cursor.eventInput = (uint32_t)input;
+	}
+	else {
+		m_cursor.eventInput = 0;
+	}
+	m_cursor.position = (uint32_t)position;
+}
+// -------------------------
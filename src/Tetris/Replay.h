@@ -0,0 +1,107 @@
+/*****************************************************************************************
+/* File: Replay.h
+/* Description: Records the inputs of a game to a compact binary file, and reads them
+/*				back so that the game can be played again exactly. Only the seed, the
+/*				rules and the ticks that had inputs are stored - the game's rules are
+/*				deterministic, so that is all it takes to rebuild everything else
+/*
+/* Rachel Pearson 2022
+/*
+/*****************************************************************************************/
+
+// ------ Includes -----
+#include <stdio.h>
+#include <stdint.h>
+#include <vector>
+// ---------------------
+
+// ------ Constants -----
+constexpr auto REPLAY_MAGIC = 0x4C505254;		// "TRPL", little-endian
+constexpr auto REPLAY_FORMAT_VERSION = 1;
+constexpr auto REPLAY_HEADER_SIZE = 20;
+constexpr auto REPLAY_BUFFER_SIZE = 4096;		// Bytes held back before a write to the file
+// ----------------------
+
+#pragma once
+
+// File layout (all numbers little-endian):
+//	 u32 magic, u16 format version, u16 ruleset version,
+//	 u8 board width, u8 board height, u8 randomizer type, u8 unused, u64 seed
+// then one record per tick that had any input:
+//	 varint ticks since the previous record, varint input mask
+// and finally an end record with an input mask of 0, giving the tick the game stopped on.
+// Varints are 7 bits per byte, lowest first, with the top bit set on all but the last byte
+struct ReplayHeader {
+	uint64_t seed;
+	int rulesetVersion;
+	int boardWidth;
+	int boardHeight;
+	int randomizerType;
+};
+
+// Where playback of a replay has got to, so that it can be picked up again later
+// from the same place (see ReplayArchive)
+struct ReplayCursor {
+	uint32_t tick;			// Next tick to hand out
+	uint32_t position;		// Next byte of the replay to read
+	uint32_t eventTick;		// Tick of the next record
+	uint32_t eventInput;	// Input mask of the next record, 0 for the end
+};
+
+// Appends to the file through a buffer of its own, so recording a tick is normally
+// just a few bytes copied into memory
+class ReplayWriter
+{
+	public:
+		ReplayWriter();
+		~ReplayWriter();
+		bool Open(const char* path, const ReplayHeader& header);
+		bool IsOpen();
+		void RecordTick(uint32_t tick, uint32_t input);
+		bool Close(uint32_t tickCount);
+
+	private:
+		FILE* m_file;
+		uint8_t m_buffer[REPLAY_BUFFER_SIZE];
+		int m_bufferUsed;
+		uint32_t m_lastTick;		// Tick of the last record written
+		bool m_failed;				// Set once a write fails, until the next file is opened
+
+		void WriteByte(uint8_t value);
+		void WriteVarint(uint64_t value);
+		void Flush();
+};
+
+// Reads a replay from memory, and hands out its inputs one tick at a time. The memory
+// is either a copy of a replay file, or (with OpenMemory) a replay that is already in
+// memory, which is read in place and must outlive the reader
+class ReplayReader
+{
+	public:
+		ReplayReader();
+		bool Open(const char* path);
+		bool OpenMemory(const uint8_t* data, size_t size);
+		bool OpenMemory(const uint8_t* data, size_t size, uint32_t tickCount, bool complete);
+		const ReplayHeader& GetHeader();
+		const uint8_t* GetData();
+		size_t GetSize();
+		uint32_t GetTickCount();
+		bool IsComplete();
+		ReplayCursor GetCursor();
+		void SetCursor(const ReplayCursor& cursor);
+		void Rewind();
+		bool NextTick(uint32_t* input);
+
+	private:
+		std::vector<uint8_t> m_file;	// Copy of the file, when opened from one
+		const uint8_t* m_data;
+		size_t m_size;
+		ReplayHeader m_header;
+		uint32_t m_tickCount;			// Ticks the game ran for
+		bool m_complete;				// Whether the replay had its end record
+		ReplayCursor m_cursor;
+
+		bool ReadHeader();
+		bool ReadVarint(size_t* position, uint64_t* value);
+		void ReadEvent();
+};
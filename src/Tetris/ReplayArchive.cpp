@@ -0,0 +1,521 @@
+/*****************************************************************************************
+/* File: ReplayArchive.cpp
+/* Description: An archive file holding many replays, each with keyframes - full copies
+/*				of the game state taken every so often - so that any tick of any game can
+/*				be reached by loading the keyframe before it and playing on from there,
+/*				rather than playing the whole game from the start
+/*
+/* Rachel Pearson 2022
+/*
+/*****************************************************************************************/
+
+#include "ReplayArchive.h"
+#include <algorithm>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/*
+==================
+Gets the number of bytes each keyframe takes for a board type,
+padded so that the next one starts aligned
+==================
+*/
+template <class BoardType>
+static uint32_t GetKeyframeSize() {
+	size_t size = sizeof(ArchiveKeyframe) + sizeof(GameState<BoardType>);
+	return (uint32_t)((size + ARCHIVE_ALIGNMENT - 1) / ARCHIVE_ALIGNMENT * ARCHIVE_ALIGNMENT);
+}
+
+/*
+==================
+Checks whether a replay was recorded on a given board type
+==================
+*/
+template <class BoardType>
+static bool IsBoardSize(const ReplayHeader& header) {
+	return header.boardWidth == BoardType::WIDTH && header.boardHeight == BoardType::HEIGHT;
+}
+
+// ------ ReplayArchiveWriter -----
+
+/*
+==================
+Constructor
+==================
+*/
+ReplayArchiveWriter::ReplayArchiveWriter() {
+	m_file = NULL;
+	m_offset = 0;
+}
+
+/*
+==================
+Destructor - an archive that was never closed has no index, and
+can't be opened
+==================
+*/
+ReplayArchiveWriter::~ReplayArchiveWriter() {
+	if (m_file != NULL) {
+		fclose(m_file);
+	}
+}
+
+/*
+==================
+Creates the archive file, leaving room for its header
+
+Parameters:
+>> path		File to write to; replaced if it exists
+
+Returns:
+>> True if the file could be created
+==================
+*/
+bool ReplayArchiveWriter::Open(const char* path) {
+	m_file = fopen(path, "wb");
+	if (m_file == NULL) {
+		return false;
+	}
+	m_offset = 0;
+	m_entries.clear();
+
+	ArchiveHeader header = {};
+	Write(&header, sizeof(header));
+	return true;
+}
+
+/*
+==================
+Adds a replay to the archive - copies it in, then plays it through
+to take a keyframe every ARCHIVE_KEYFRAME_INTERVAL ticks. The
+replay must have been recorded with the current rules
+
+Parameters:
+>> replay	The replay to add; it is left rewound
+
+Returns:
+>> False if the replay's rules or board size aren't supported
+==================
+*/
+bool ReplayArchiveWriter::AddReplay(ReplayReader* replay) {
+	const ReplayHeader& header = replay->GetHeader();
+
+	// Everything is checked before anything is written, so that a replay
+	// that can't be added leaves nothing behind in the archive
+	bool supportedBoard = IsBoardSize<StandardBoard>(header) || IsBoardSize<NarrowBoard>(header) ||
+						  IsBoardSize<TallBoard>(header) || IsBoardSize<WideBoard>(header);
+	if (m_file == NULL || header.rulesetVersion != RULESET_VERSION || !supportedBoard) {
+		return false;
+	}
+
+	ArchiveEntry entry = {};
+	entry.seed = header.seed;
+	entry.replaySize = (uint32_t)replay->GetSize();
+	entry.tickCount = replay->GetTickCount();
+	entry.boardWidth = (uint16_t)header.boardWidth;
+	entry.boardHeight = (uint16_t)header.boardHeight;
+	entry.complete = replay->IsComplete() ? 1 : 0;
+
+	Align();
+	entry.replayOffset = m_offset;
+	Write(replay->GetData(), replay->GetSize());
+	Align();
+	entry.keyframeOffset = m_offset;
+
+	if (IsBoardSize<StandardBoard>(header)) {
+		WriteKeyframes<StandardBoard>(replay, &entry);
+	}
+	else if (IsBoardSize<NarrowBoard>(header)) {
+		WriteKeyframes<NarrowBoard>(replay, &entry);
+	}
+	else if (IsBoardSize<TallBoard>(header)) {
+		WriteKeyframes<TallBoard>(replay, &entry);
+	}
+	else {
+		WriteKeyframes<WideBoard>(replay, &entry);
+	}
+
+	m_entries.push_back(entry);
+	return true;
+}
+
+/*
+==================
+Plays a replay through from the start, writing a keyframe of the
+game state every ARCHIVE_KEYFRAME_INTERVAL ticks, starting with
+tick 0
+
+Parameters:
+>> replay	The replay to play
+>> entry	Its index entry; the keyframe count and size are set
+==================
+*/
+template <class BoardType>
+void ReplayArchiveWriter::WriteKeyframes(ReplayReader* replay, ArchiveEntry* entry) {
+	const ReplayHeader& header = replay->GetHeader();
+	Game<BoardType>* game = new Game<BoardType>(header.seed, header.randomizerType);
+	GameState<BoardType>* state = new GameState<BoardType>();
+	uint32_t keyframeSize = GetKeyframeSize<BoardType>();
+	uint8_t padding[ARCHIVE_ALIGNMENT] = {};
+	uint32_t input = 0;
+
+	entry->keyframeSize = keyframeSize;
+	entry->keyframeCount = 0;
+	replay->Rewind();
+	for (;;) {
+		if (replay->GetCursor().tick % ARCHIVE_KEYFRAME_INTERVAL == 0) {
+			ArchiveKeyframe keyframe;
+			keyframe.cursor = replay->GetCursor();
+			game->SaveState(state);
+
+			Write(&keyframe, sizeof(keyframe));
+			Write(state, sizeof(*state));
+			Write(padding, keyframeSize - sizeof(keyframe) - sizeof(*state));
+			entry->keyframeCount++;
+		}
+		if (!replay->NextTick(&input)) {
+			break;
+		}
+		game->Tick(input);
+	}
+
+	replay->Rewind();
+	delete state;
+	delete game;
+}
+
+/*
+==================
+Writes the index, sorted by seed, and then the header, and closes
+the file
+
+Returns:
+>> True if everything was written
+==================
+*/
+bool ReplayArchiveWriter::Close() {
+	if (m_file == NULL) {
+		return false;
+	}
+
+	// Games with the same seed keep the order they were added in
+	std::stable_sort(m_entries.begin(), m_entries.end(), [](const ArchiveEntry& a, const ArchiveEntry& b) {
+		return a.seed < b.seed;
+	});
+	Align();
+	ArchiveHeader header = {};
+	header.magic = ARCHIVE_MAGIC;
+	header.formatVersion = ARCHIVE_FORMAT_VERSION;
+	header.rulesetVersion = RULESET_VERSION;
+	header.gameCount = (uint32_t)m_entries.size();
+	header.indexOffset = m_offset;
+	Write(m_entries.data(), m_entries.size() * sizeof(ArchiveEntry));
+
+	bool written = (fseek(m_file, 0, SEEK_SET) == 0) && (fwrite(&header, sizeof(header), 1, m_file) == 1);
+	written = !ferror(m_file) && written;
+	written = (fclose(m_file) == 0) && written;
+	m_file = NULL;
+	return written;
+}
+
+void ReplayArchiveWriter::Write(const void* data, size_t size) {
+	fwrite(data, 1, size, m_file);
+	m_offset += size;
+}
+
+void ReplayArchiveWriter::Align() {
+	uint8_t padding[ARCHIVE_ALIGNMENT] = {};
+	Write(padding, (ARCHIVE_ALIGNMENT - m_offset % ARCHIVE_ALIGNMENT) % ARCHIVE_ALIGNMENT);
+}
+
+// --------------------------------
+
+// ------ ReplayArchive -----
+
+/*
+==================
+Constructor
+==================
+*/
+ReplayArchive::ReplayArchive() {
+	m_data = NULL;
+	m_size = 0;
+	m_entries = NULL;
+	m_gameCount = 0;
+#ifdef _WIN32
+	m_fileHandle = INVALID_HANDLE_VALUE;
+	m_mappingHandle = NULL;
+#else
+	m_fileHandle = -1;
+#endif
+}
+
+/*
+==================
+Destructor
+==================
+*/
+ReplayArchive::~ReplayArchive() {
+	Close();
+}
+
+/*
+==================
+Maps an archive file into memory and checks its header and index.
+Nothing else is read until it is used
+
+Parameters:
+>> path		File to open
+
+Returns:
+>> True if it is an archive this build can read
+==================
+*/
+bool ReplayArchive::Open(const char* path) {
+	Close();
+
+#ifdef _WIN32
+	m_fileHandle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (m_fileHandle == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(m_fileHandle, &fileSize) || fileSize.QuadPart < (LONGLONG)sizeof(ArchiveHeader)) {
+		Close();
+		return false;
+	}
+	m_mappingHandle = CreateFileMappingA(m_fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (m_mappingHandle == NULL) {
+		Close();
+		return false;
+	}
+	m_data = (const uint8_t*)MapViewOfFile(m_mappingHandle, FILE_MAP_READ, 0, 0, 0);
+	m_size = (size_t)fileSize.QuadPart;
+#else
+	m_fileHandle = open(path, O_RDONLY);
+	if (m_fileHandle < 0) {
+		return false;
+	}
+	struct stat fileStat;
+	if (fstat(m_fileHandle, &fileStat) != 0 || fileStat.st_size < (off_t)sizeof(ArchiveHeader)) {
+		Close();
+		return false;
+	}
+	void* mapped = mmap(NULL, (size_t)fileStat.st_size, PROT_READ, MAP_PRIVATE, m_fileHandle, 0);
+	m_data = (mapped == MAP_FAILED) ? NULL : (const uint8_t*)mapped;
+	m_size = (size_t)fileStat.st_size;
+#endif
+	if (m_data == NULL) {
+		Close();
+		return false;
+	}
+
+	const ArchiveHeader* header = (const ArchiveHeader*)m_data;
+	if (header->magic != (uint32_t)ARCHIVE_MAGIC || header->formatVersion != ARCHIVE_FORMAT_VERSION ||
+		header->rulesetVersion != RULESET_VERSION || header->indexOffset > m_size ||
+		header->indexOffset % ARCHIVE_ALIGNMENT != 0 ||
+		(m_size - header->indexOffset) / sizeof(ArchiveEntry) < header->gameCount) {
+		Close();
+		return false;
+	}
+	m_entries = (const ArchiveEntry*)(m_data + header->indexOffset);
+	m_gameCount = (int)header->gameCount;
+
+	// Every game's data must be inside the file. The checks subtract rather
+	// than add, so that offsets in a corrupt index can't wrap around past
+	// them. Keyframes are read in place as game state, so they must be aligned
+	for (int i = 0; i < m_gameCount; i++) {
+		const ArchiveEntry& entry = m_entries[i];
+		uint64_t keyframeBytes = (uint64_t)entry.keyframeCount * entry.keyframeSize;
+		if (entry.replayOffset > m_size || entry.replaySize > m_size - entry.replayOffset ||
+			entry.keyframeOffset > m_size || keyframeBytes > m_size - entry.keyframeOffset ||
+			entry.keyframeOffset % ARCHIVE_ALIGNMENT != 0 || entry.keyframeSize % ARCHIVE_ALIGNMENT != 0) {
+			Close();
+			return false;
+		}
+	}
+	return true;
+}
+
+/*
+==================
+Unmaps the archive, if one is open
+==================
+*/
+void ReplayArchive::Close() {
+#ifdef _WIN32
+	if (m_data != NULL) {
+		UnmapViewOfFile(m_data);
+	}
+	if (m_mappingHandle != NULL) {
+		CloseHandle(m_mappingHandle);
+	}
+	if (m_fileHandle != INVALID_HANDLE_VALUE) {
+		CloseHandle(m_fileHandle);
+	}
+	m_fileHandle = INVALID_HANDLE_VALUE;
+	m_mappingHandle = NULL;
+#else
+	if (m_data != NULL) {
+		munmap((void*)m_data, m_size);
+	}
+	if (m_fileHandle >= 0) {
+		close(m_fileHandle);
+	}
+	m_fileHandle = -1;
+#endif
+	m_data = NULL;
+	m_size = 0;
+	m_entries = NULL;
+	m_gameCount = 0;
+}
+
+// ------ Getters & Setters -----
+int ReplayArchive::GetGameCount() {
+	return m_gameCount;
+}
+
+const ArchiveEntry* ReplayArchive::GetEntry(int game) {
+	return &m_entries[game];
+}
+// ------------------------------
+
+/*
+==================
+Finds a game by its seed, with a binary search of the index
+
+Parameters:
+>> seed		The seed the game was played with
+
+Returns:
+>> The game's number in the archive, or -1 if it isn't there.
+   If several games have the seed, the first one added
+==================
+*/
+int ReplayArchive::FindGame(uint64_t seed) {
+	const ArchiveEntry* end = m_entries + m_gameCount;
+	const ArchiveEntry* entry = std::lower_bound(m_entries, end, seed, [](const ArchiveEntry& a, uint64_t value) {
+		return a.seed < value;
+	});
+
+	if (entry == end || entry->seed != seed) {
+		return -1;
+	}
+	return (int)(entry - m_entries);
+}
+
+/*
+==================
+Opens one game's replay where it lies in the archive, without
+copying or reading through it
+
+Parameters:
+>> game		The game's number in the archive
+>> replay	Reader to open it with; only valid while the
+			archive is open
+
+Returns:
+>> True if the replay could be read
+==================
+*/
+bool ReplayArchive::OpenReplay(int game, ReplayReader* replay) {
+	const ArchiveEntry* entry = GetEntry(game);
+	return replay->OpenMemory(m_data + entry->replayOffset, entry->replaySize, entry->tickCount, entry->complete != 0);
+}
+
+/*
+==================
+Finds the last keyframe of a game at or before a tick, with a
+binary search of the game's keyframes
+
+Parameters:
+>> game		The game's number in the archive
+>> tick		The tick to look for
+
+Returns:
+>> The keyframe, followed in memory by its game state, or NULL if
+   the game has no keyframes
+==================
+*/
+const ArchiveKeyframe* ReplayArchive::FindKeyframe(int game, uint32_t tick) {
+	const ArchiveEntry* entry = GetEntry(game);
+	const uint8_t* keyframes = m_data + entry->keyframeOffset;
+	uint32_t low = 0;
+	uint32_t high = entry->keyframeCount;
+
+	// Keyframes are in tick order; find the first one after the tick
+	while (low < high) {
+		uint32_t middle = low + (high - low) / 2;
+		const ArchiveKeyframe* keyframe = (const ArchiveKeyframe*)(keyframes + (size_t)middle * entry->keyframeSize);
+		if (keyframe->cursor.tick <= tick) {
+			low = middle + 1;
+		}
+		else {
+			high = middle;
+		}
+	}
+
+	if (low == 0) {
+		return NULL;
+	}
+	return (const ArchiveKeyframe*)(keyframes + (size_t)(low - 1) * entry->keyframeSize);
+}
+
+/*
+==================
+Puts a game into the state it was in at a given tick of one of the
+archive's games - loads the keyframe before the tick, then plays
+the replay on from there. At most ARCHIVE_KEYFRAME_INTERVAL - 1
+ticks are played. Playback can carry on from there with
+replay->NextTick and target->Tick
+
+Parameters:
+>> game		The game's number in the archive
+>> tick		The tick to seek to; past the end of the game, it
+			stops at the end
+>> target	The game to put into that state; its board type
+			must match the archived game's board size
+>> replay	Reader left at the tick, for carrying on
+
+Returns:
+>> False if the game's board size or keyframe layout don't match
+==================
+*/
+template <class BoardType>
+bool ReplayArchive::Seek(int game, uint32_t tick, Game<BoardType>* target, ReplayReader* replay) {
+	const ArchiveEntry* entry = GetEntry(game);
+	if (entry->boardWidth != BoardType::WIDTH || entry->boardHeight != BoardType::HEIGHT ||
+		entry->keyframeSize != GetKeyframeSize<BoardType>() || !OpenReplay(game, replay)) {
+		return false;
+	}
+
+	const ArchiveKeyframe* keyframe = FindKeyframe(game, tick);
+	if (keyframe == NULL) {
+		return false;
+	}
+	target->LoadState((GameState<BoardType>*)(keyframe + 1));
+	replay->SetCursor(keyframe->cursor);
+
+	uint32_t input;
+	while (replay->GetCursor().tick < tick && replay->NextTick(&input)) {
+		target->Tick(input);
+	}
+	return true;
+}
+
+// --------------------------
+
+// ----- Board instantiations -----
+template bool ReplayArchive::Seek<StandardBoard>(int, uint32_t, Game<StandardBoard>*, ReplayReader*);
+template bool ReplayArchive::Seek<NarrowBoard>(int, uint32_t, Game<NarrowBoard>*, ReplayReader*);
+template bool ReplayArchive::Seek<TallBoard>(int, uint32_t, Game<TallBoard>*, ReplayReader*);
+template bool ReplayArchive::Seek<WideBoard>(int, uint32_t, Game<WideBoard>*, ReplayReader*);
+// --------------------------------
@@ -0,0 +1,114 @@
+/*****************************************************************************************
+/* File: ReplayArchive.h
+/* Description: An archive file holding many replays, each with keyframes - full copies
+/*				of the game state taken every so often - so that any tick of any game can
+/*				be reached by loading the keyframe before it and playing on from there,
+/*				rather than playing the whole game from the start
+/*
+/* Rachel Pearson 2022
+/*
+/*****************************************************************************************/
+
+// ------ Includes -----
+#include <stdio.h>
+#include <stdint.h>
+#include <vector>
+#include "Game.h"
+#include "Replay.h"
+// ---------------------
+
+// ------ Constants -----
+constexpr auto ARCHIVE_MAGIC = 0x43524154;			// "TARC", little-endian
+constexpr auto ARCHIVE_FORMAT_VERSION = 1;
+constexpr auto ARCHIVE_KEYFRAME_INTERVAL = 600;		// Ticks between keyframes (10 seconds of play)
+constexpr auto ARCHIVE_ALIGNMENT = 8;				// Replays and keyframes start on multiples of this
+// ----------------------
+
+#pragma once
+
+// File layout: an ArchiveHeader, then for each game its replay (exactly as in a replay
+// file) followed by its keyframes, then the index - an ArchiveEntry per game, sorted
+// by seed. Keyframes are an ArchiveKeyframe followed by the raw GameState, in tick
+// order. As keyframes are raw game state, an archive can only be read by a build of
+// the game with the same rules and the same struct layouts as the one that wrote it;
+// the ruleset version and each keyframe's size are checked when it is opened
+
+struct ArchiveHeader {
+	uint32_t magic;
+	uint16_t formatVersion;
+	uint16_t rulesetVersion;
+	uint32_t gameCount;
+	uint32_t unused;
+	uint64_t indexOffset;		// Where the index starts in the file
+};
+
+struct ArchiveEntry {
+	uint64_t seed;
+	uint64_t replayOffset;
+	uint64_t keyframeOffset;
+	uint32_t replaySize;
+	uint32_t tickCount;
+	uint32_t keyframeCount;
+	uint32_t keyframeSize;		// Bytes from one keyframe to the next
+	uint16_t boardWidth;
+	uint16_t boardHeight;
+	uint32_t complete;			// Non-zero if the replay has its end record
+};
+
+struct ArchiveKeyframe {
+	ReplayCursor cursor;		// Where the replay's playback had got to; cursor.tick is the keyframe's tick
+};
+
+// Builds an archive from replays. Each replay is played through once as it is added,
+// to take its keyframes; the index is written when the archive is closed
+class ReplayArchiveWriter
+{
+	public:
+		ReplayArchiveWriter();
+		~ReplayArchiveWriter();
+		bool Open(const char* path);
+		bool AddReplay(ReplayReader* replay);
+		bool Close();
+
+	private:
+		FILE* m_file;
+		uint64_t m_offset;						// Bytes written so far
+		std::vector<ArchiveEntry> m_entries;
+
+		template <class BoardType>
+		void WriteKeyframes(ReplayReader* replay, ArchiveEntry* entry);
+		void Write(const void* data, size_t size);
+		void Align();
+};
+
+// Maps an archive into memory, so that opening it reads nothing up front and each game's
+// replay and keyframes are used in place
+class ReplayArchive
+{
+	public:
+		ReplayArchive();
+		~ReplayArchive();
+		bool Open(const char* path);
+		void Close();
+		int GetGameCount();
+		const ArchiveEntry* GetEntry(int game);
+		int FindGame(uint64_t seed);
+		bool OpenReplay(int game, ReplayReader* replay);
+		const ArchiveKeyframe* FindKeyframe(int game, uint32_t tick);
+		template <class BoardType>
+		bool Seek(int game, uint32_t tick, Game<BoardType>* target, ReplayReader* replay);
+
+	private:
+		const uint8_t* m_data;
+		size_t m_size;
+		const ArchiveEntry* m_entries;
+		int m_gameCount;
+
+		// Handles kept open for as long as the file is mapped
+#ifdef _WIN32
+		void* m_fileHandle;
+		void* m_mappingHandle;
+#else
+		int m_fileHandle;
+#endif
+};
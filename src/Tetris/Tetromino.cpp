@@ -1,7 +1,7 @@
 /*****************************************************************************************
 /* File: Tetromino.cpp
-/* Description: The Tetromino object - has a shape, color, position, and template which is
-/*				used to map it to the board. Can manipulate its own template e.g. rotation
+/* Description: The Tetromino object - has a shape, rotation, color and position. Its tiles
+/*				are looked up in a table of rotation states built at compile time
 /*
 /* Rachel Pearson 2022
 /*
@@ -9,16 +9,19 @@
 
 #include "Tetromino.h"
 
+constexpr TetrominoStateTable Tetromino::s_states;
+
 /*
 ==================
 Constructor
 ==================
 */
 Tetromino::Tetromino(int shape, int color) {
-	m_shape = shape;
-	m_color = color;
-
-	Initialise();
+	m_shape = (int8_t)shape;
+	m_color = (int8_t)color;
+	m_rotation = 0;
+	m_pivotXTile = 0;
+	m_pivotYTile = 0;
 }
 
 // ------ Getters & Setters -----
@@ -27,7 +30,7 @@ int Tetromino::GetPivotXTile() {
 }
 
 void Tetromino::SetPivotXTile(int x) {
-	m_pivotXTile = x;
+	m_pivotXTile = (int8_t)x;
 }
 
 int Tetromino::GetPivotYTile() {
@@ -35,62 +38,58 @@ int Tetromino::GetPivotYTile() {
 }
 
 void Tetromino::SetPivotYTile(int y) {
-	m_pivotYTile = y;
+	m_pivotYTile = (int8_t)y;
 }
 
 /*
 ==================
-Get the horizontal board tile that a given index maps to
+Get the rotation state the Tetromino is currently in
 ==================
 */
-int Tetromino::GetXTile(int indexX) {
-	return (indexX + m_pivotXTile - GetPivotXIndex());
+const TetrominoState& Tetromino::GetState() {
+	return s_states.states[m_shape][m_rotation];
+}
+
+int Tetromino::GetRotation() {
+	return m_rotation;
 }
 
 /*
 ==================
-Get the vertical board tile that a given index maps to
+Get the horizontal board tile that a given tile (0 to 3) is on
 ==================
 */
-int Tetromino::GetYTile(int indexY) {
-	return (indexY + m_pivotYTile - GetPivotYIndex());
+int Tetromino::GetTileX(int tile) {
+	return m_pivotXTile + GetState().tileX[tile];
 }
 
-int Tetromino::GetTemplate(int indexX, int indexY)
-{
-	return m_template[indexY][indexX];
+/*
+==================
+Get the vertical board tile that a given tile (0 to 3) is on
+==================
+*/
+int Tetromino::GetTileY(int tile) {
+	return m_pivotYTile + GetState().tileY[tile];
 }
 
 /*
 ==================
-Get the horizontal index of the pivot within the template
+Get the horizontal index of a given tile (0 to 3) within the
+4x4 template, used when drawing the Tetromino outside the board
 ==================
 */
-int Tetromino::GetPivotXIndex() {
-	for (int i = 0; i < TET_TEMPLATE_SIZE; i++) {
-		for (int j = 0; j < TET_TEMPLATE_SIZE; j++) {
-			if (m_template[i][j] == 2) {
-				return j;
-			}
-		}
-	}
-	return -1;
+int Tetromino::GetTemplateX(int tile) {
+	return GetState().pivotX + GetState().tileX[tile];
 }
 
 /*
 ==================
-Get the vertical index of the pivot within the template
+Get the vertical index of a given tile (0 to 3) within the
+4x4 template, used when drawing the Tetromino outside the board
 ==================
 */
-int Tetromino::GetPivotYIndex() {
-	for (int i = 0; i < TET_TEMPLATE_SIZE; i++) {
-		for (int j = 0; j < TET_TEMPLATE_SIZE; j++) {
-			if (m_template[i][j] == 2) {
-				return i;
-			}
-		}
-	}
-	return -1;
+int Tetromino::GetTemplateY(int tile) {
+	return GetState().pivotY + GetState().tileY[tile];
 }
 
 int Tetromino::GetColor() {
@@ -98,7 +97,7 @@ int Tetromino::GetColor() {
 }
 
 void Tetromino::SetColor(int color) {
-	m_color = color;
+	m_color = (int8_t)color;
 }
 
 int Tetromino::GetShape() {
@@ -106,72 +105,29 @@ int Tetromino::GetShape() {
 }
 
 void Tetromino::SetShape(int shape) {
-
-	m_shape = shape;
-
-	for (int i = 0; i < TET_TEMPLATE_SIZE; i++) {
-		for (int j = 0; j < TET_TEMPLATE_SIZE; j++) {
-			m_template[i][j] = m_templates[shape][i][j];
-		}
-	}
+	m_shape = (int8_t)shape;
+	m_rotation = 0;
 }
 // ------------------------------
 
 /*
 ==================
-Initialises the Tetromino by setting its template to the
-correct one for its shape
-==================
-*/
-void Tetromino::Initialise() {
-	for (int i = 0; i < TET_TEMPLATE_SIZE; i++) {
-		for (int j = 0; j < TET_TEMPLATE_SIZE; j++) {
-			m_template[i][j] = m_templates[m_shape][i][j];
-		}
-	}
-}
-
-/*
-==================
-Rotates the Tetromino 90 degrees clockwise by changing its template
-The center of rotation is the pivot - the tile marked as 2 / TET_PIVOT
+Rotates the Tetromino 90 degrees clockwise by moving to its next
+rotation state
+The shape turns within its box, as in the Super Rotation System
 ==================
 */
 void Tetromino::Rotate() {
-	int m_newRotation[TET_TEMPLATE_SIZE][TET_TEMPLATE_SIZE];
-
-	for (int i = 0; i < TET_TEMPLATE_SIZE; i++) {
-		for (int j = 0; j < TET_TEMPLATE_SIZE; j++) {
-			m_newRotation[i][j] = m_template[(TET_TEMPLATE_SIZE - 1) - j][i];
-		}
-	}
-
-	for (int i = 0; i < TET_TEMPLATE_SIZE; i++) {
-		for (int j = 0; j < TET_TEMPLATE_SIZE; j++) {
-			m_template[i][j] = m_newRotation[i][j];
-		}
-	}
+	m_rotation = (int8_t)((m_rotation + 1) % TET_ROTATION_COUNT);
 }
 
 /*
 ==================
-Rotates the Tetromino 90 degrees anticlockwise by changing its template
-The center of rotation is the pivot - the tile marked as 2 / TET_PIVOT
+Rotates the Tetromino 90 degrees anticlockwise by moving to its
+previous rotation state
+The shape turns within its box, as in the Super Rotation System
 ==================
 */
 void Tetromino::ReverseRotate() {
-	int m_newRotation[TET_TEMPLATE_SIZE][TET_TEMPLATE_SIZE];
-
-	for (int i = 0; i < TET_TEMPLATE_SIZE; i++) {
-		for (int j = 0; j < TET_TEMPLATE_SIZE; j++) {
-			m_newRotation[i][j] = m_template[j][(TET_TEMPLATE_SIZE - 1) - i];
-		}
-	}
-
-	for (int i = 0; i < TET_TEMPLATE_SIZE; i++) {
-		for (int j = 0; j < TET_TEMPLATE_SIZE; j++) {
-			m_template[i][j] = m_newRotation[i][j];
-		}
-	}
-}
-
+	m_rotation = (int8_t)((m_rotation + TET_ROTATION_COUNT - 1) % TET_ROTATION_COUNT);
+}
\ No newline at end of file
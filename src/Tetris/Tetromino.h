@@ -1,65 +1,41 @@
 /*****************************************************************************************
 /* File: Tetromino.h
-/* Description: The Tetromino object - has a shape, color, position, and template which is
-/*				used to map it to the board. Can manipulate its own template e.g. rotation
+/* Description: The Tetromino object - has a shape, rotation, color and position. Its tiles
+/*				are looked up in a table of rotation states built at compile time
 /*
 /* Rachel Pearson 2022
 /*
 /*****************************************************************************************/
 
+// ------ Includes -----
+#include <stdint.h>
+#include <type_traits>
+// ---------------------
+
 // ------ Constants -----
 constexpr auto TET_TEMPLATE_SIZE = 4;
+constexpr auto TET_SHAPE_COUNT = 7;
+constexpr auto TET_ROTATION_COUNT = 4;
+constexpr auto TET_TILE_COUNT = 4;
 // ----------------------
 
 // ------ Enums --------
 enum { I, J, L, O, S, T, Z };
 // ---------------------
 
+// --- Tables of Tetromino shapes and their rotation states ---
 
-#pragma once
-class Tetromino
-{
-public:
-	Tetromino(int shape, int color);
-	int GetPivotXTile();
-	void SetPivotXTile(int x);
-	int GetPivotYTile();
-	void SetPivotYTile(int y);
-	int GetColor();
-	void SetColor(int color);
-	int GetShape();
-	void SetShape(int shape);
-	int GetXTile(int indexX);
-	int GetYTile(int indexY);
-	int GetTemplate(int indexX, int indexY);
-	void Rotate();
-	void ReverseRotate();
-
-private:
-	void Initialise();
-	int GetPivotXIndex();
-	int GetPivotYIndex();
-
-	int m_shape;
-	int m_color;
-
-	// Pivot tiles are the tile that the Tetromino rotates around,
-	// and the Tetromino is stored using them here
-	int m_pivotXTile;		// Horizontal tile of the board the pivot is on
-	int m_pivotYTile;		// Vertical tile of the board the pivot is on
-	
-	// The Tetromino's template, stores its shape as a 2D array
-	int m_template[TET_TEMPLATE_SIZE][TET_TEMPLATE_SIZE];
-
-	// Constant for all possible templates, one for each shape;
-	// 1 = regular Tetromino tile, 2 = pivot tile
-	const int m_templates[7][TET_TEMPLATE_SIZE][TET_TEMPLATE_SIZE] 
+// Templates for all possible shapes, one for each shape, in their Super Rotation
+// System spawn rotation; 1 = regular Tetromino tile, 2 = pivot tile
+// The pivot is the tile the Tetromino is positioned by - it stays in the same
+// place in the template as the shape rotates, so it is not always filled
+constexpr int TET_TEMPLATES[TET_SHAPE_COUNT][TET_TEMPLATE_SIZE][TET_TEMPLATE_SIZE]
 										= {
 											{
-											{0, 1, 0, 0},
-											{0, 1, 0, 0},
-											{0, 2, 0, 0},
-											{0, 1, 0, 0},
+											{0, 0, 0, 0},
+											{1, 2, 1, 1},
+											{0, 0, 0, 0},
+											{0, 0, 0, 0},
 											},
 											{
 											{1, 0, 0, 0},
@@ -98,5 +74,155 @@ private:
 											{0, 0, 0, 0},
 											}
 											};
+
+// Size of the square box each shape rotates within, from the top left of its template;
+// the I rotates within 4x4, the O within 2x2 (so it does not move), and the rest within 3x3
+constexpr int TET_BOX_SIZES[TET_SHAPE_COUNT] = { 4, 3, 3, 2, 3, 3, 3 };
+
+// One rotation state of a shape - where each of its tiles sits relative to the pivot,
+// and where the pivot sits within the (rotated) template
+struct TetrominoState {
+	int8_t tileX[TET_TILE_COUNT];	// Horizontal offset of each tile from the pivot
+	int8_t tileY[TET_TILE_COUNT];	// Vertical offset of each tile from the pivot
+	int8_t pivotX;					// Horizontal index of the pivot within the template
+	int8_t pivotY;					// Vertical index of the pivot within the template
+
+	// Bounding box of the tiles, relative to the pivot
+	int8_t minX;
+	int8_t maxX;
+	int8_t minY;
+	int8_t maxY;
+
+	// The tiles as one mask per row of the bounding box, top to bottom; bit k is
+	// set when the tile at minX + k is filled, so a row can be shifted into place
+	// and tested against a board row in one go
+	uint8_t rowMasks[TET_TEMPLATE_SIZE];
+	int8_t rowCount;
+};
+
+struct TetrominoStateTable {
+	TetrominoState states[TET_SHAPE_COUNT][TET_ROTATION_COUNT];
 };
 
+/*
+==================
+Builds the rotation states of every shape by rotating its template 90 degrees
+clockwise within the shape's box, once per rotation, as the Super Rotation System
+does. The pivot keeps its place in the template, and tiles are recorded relative
+to it in the order they appear in the template, left to right then top to bottom.
+They are then packed into row masks for collision tests
+==================
+*/
+constexpr TetrominoStateTable BuildTetrominoStates() {
+	TetrominoStateTable table = {};
+
+	for (int shape = 0; shape < TET_SHAPE_COUNT; shape++) {
+		int boxSize = TET_BOX_SIZES[shape];
+		int pivotX = 0;
+		int pivotY = 0;
+		int tmpl[TET_TEMPLATE_SIZE][TET_TEMPLATE_SIZE] = {};
+		for (int i = 0; i < TET_TEMPLATE_SIZE; i++) {
+			for (int j = 0; j < TET_TEMPLATE_SIZE; j++) {
+				tmpl[i][j] = TET_TEMPLATES[shape][i][j];
+				if (tmpl[i][j] == 2) {
+					pivotX = j;
+					pivotY = i;
+				}
+			}
+		}
+
+		for (int rotation = 0; rotation < TET_ROTATION_COUNT; rotation++) {
+			TetrominoState& state = table.states[shape][rotation];
+
+			// Record each tile relative to the pivot
+			state.pivotX = (int8_t)pivotX;
+			state.pivotY = (int8_t)pivotY;
+			int tile = 0;
+			for (int i = 0; i < TET_TEMPLATE_SIZE; i++) {
+				for (int j = 0; j < TET_TEMPLATE_SIZE; j++) {
+					if (tmpl[i][j] != 0) {
+						state.tileX[tile] = (int8_t)(j - state.pivotX);
+						state.tileY[tile] = (int8_t)(i - state.pivotY);
+						tile++;
+					}
+				}
+			}
+
+			// Pack the tiles into one mask per row of their bounding box
+			state.minX = state.maxX = state.tileX[0];
+			state.minY = state.maxY = state.tileY[0];
+			for (int i = 1; i < TET_TILE_COUNT; i++) {
+				state.minX = (state.tileX[i] < state.minX) ? state.tileX[i] : state.minX;
+				state.maxX = (state.tileX[i] > state.maxX) ? state.tileX[i] : state.maxX;
+				state.minY = (state.tileY[i] < state.minY) ? state.tileY[i] : state.minY;
+				state.maxY = (state.tileY[i] > state.maxY) ? state.tileY[i] : state.maxY;
+			}
+			state.rowCount = (int8_t)(state.maxY - state.minY + 1);
+			for (int i = 0; i < TET_TILE_COUNT; i++) {
+				state.rowMasks[state.tileY[i] - state.minY] |= (uint8_t)(1 << (state.tileX[i] - state.minX));
+			}
+
+			// Rotate the tiles in the box clockwise for the next state
+			int rotated[TET_TEMPLATE_SIZE][TET_TEMPLATE_SIZE] = {};
+			for (int i = 0; i < boxSize; i++) {
+				for (int j = 0; j < boxSize; j++) {
+					rotated[i][j] = tmpl[(boxSize - 1) - j][i];
+				}
+			}
+			for (int i = 0; i < TET_TEMPLATE_SIZE; i++) {
+				for (int j = 0; j < TET_TEMPLATE_SIZE; j++) {
+					tmpl[i][j] = rotated[i][j];
+				}
+			}
+		}
+	}
+	return table;
+}
+// ------------------------------------------------------------
+
+
+#pragma once
+
+// A plain value type, a few bytes in size, so that it can be copied freely; the shape
+// data it refers to lives in the single shared table of rotation states
+class Tetromino
+{
+public:
+	Tetromino() = default;
+	Tetromino(int shape, int color);
+	int GetPivotXTile();
+	void SetPivotXTile(int x);
+	int GetPivotYTile();
+	void SetPivotYTile(int y);
+	int GetColor();
+	void SetColor(int color);
+	int GetShape();
+	void SetShape(int shape);
+	int GetRotation();
+	int GetTileX(int tile);
+	int GetTileY(int tile);
+	int GetTemplateX(int tile);
+	int GetTemplateY(int tile);
+	void Rotate();
+	void ReverseRotate();
+
+	// Every rotation state of every shape, built at compile time
+	static constexpr TetrominoStateTable s_states = BuildTetrominoStates();
+
+private:
+	const TetrominoState& GetState();
+
+	int8_t m_shape;
+	int8_t m_color;
+	int8_t m_rotation;		// Index into the shape's rotation states (0 to 3)
+
+	// Pivot tiles are the tile that the Tetromino rotates around,
+	// and the Tetromino is stored using them here
+	int8_t m_pivotXTile;	// Horizontal tile of the board the pivot is on
+	int8_t m_pivotYTile;	// Vertical tile of the board the pivot is on
+};
+
+static_assert(std::is_trivial<Tetromino>::value && std::is_standard_layout<Tetromino>::value,
+			  "Tetromino must stay a plain value type");
+static_assert(sizeof(Tetromino) <= 8, "Tetromino must stay a few bytes in size");
+
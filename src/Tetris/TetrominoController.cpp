@@ -13,24 +13,16 @@
 Constructor
 ==================
 */
-TetrominoController::TetrominoController(Board* board) {
-	srand((unsigned)time(NULL));
-
+template <class BoardType>
+TetrominoController<BoardType>::TetrominoController(BoardType* board, Tetromino* tetromino) {
 	m_board = board;
-	m_tetromino = new Tetromino(-1, -1);
-}
-
-/*
-==================
-Destructor
-==================
-*/
-TetrominoController::~TetrominoController() {
-	delete(m_tetromino);
+	m_tetromino = tetromino;
+	*m_tetromino = Tetromino(-1, -1);
 }
 
 // ------ Getters & Setters -----
-Tetromino* TetrominoController::GetTetromino() {
+template <class BoardType>
+Tetromino* TetrominoController<BoardType>::GetTetromino() {
 	return m_tetromino;
 }
 // ------------------------------
@@ -45,8 +37,9 @@ Parameters:
 >> color	Color of the 'new' Tetromino
 ==================
 */
-void TetrominoController::SpawnTetromino(int shape, int color) {
-	m_tetromino->SetPivotXTile(TET_START_X);
+template <class BoardType>
+void TetrominoController<BoardType>::SpawnTetromino(int shape, int color) {
+	m_tetromino->SetPivotXTile((BoardType::WIDTH - 1) / 2);
 	m_tetromino->SetPivotYTile(TET_START_Y);
 	m_tetromino->SetShape(shape);
 	m_tetromino->SetColor(color);
@@ -60,7 +53,8 @@ Parameters:
 >> direction	Direction to move the Tetromino in
 ==================
 */
-void TetrominoController::MoveTetromino(int direction) {
+template <class BoardType>
+void TetrominoController<BoardType>::MoveTetromino(int direction) {
 	switch (direction) {
 	case DOWN:
 		m_tetromino->SetPivotYTile(m_tetromino->GetPivotYTile() + 1);
@@ -76,72 +70,82 @@ void TetrominoController::MoveTetromino(int direction) {
 
 /*
 ==================
-Attempts to rotate the tetromino:
-- Starts by rotating normally, and checks if this is valid
-- Then attempts a wall kick (moves from the wall), and
-  checks if this is valid
-- If not, reverse the rotation and give up
-
-Returns:
->> True if the Tetromino was rotated successfully, false if
-   not
+Get how many rows the Tetromino can fall before it lands,
+worked out in one go from the board's column masks
 ==================
 */
-bool TetrominoController::RotateTetromino() {
-	m_tetromino->Rotate();
-	if (IsValidTetrominoPosition()) {
-		return true;
-	}
-	else if (WallKickTetromino()) {
-		return true;
-	}
-	else {
-		m_tetromino->ReverseRotate();
-		return false;
-	}
+template <class BoardType>
+int TetrominoController<BoardType>::GetDropDistance() {
+	return m_board->GetDropDistance(m_tetromino);
 }
 
 /*
 ==================
-Resets the Tetromino to its starting position and
-resets its shape
+Moves the Tetromino straight down to where it would land
 ==================
 */
-void TetrominoController::ResetTetromino()
-{
-	m_tetromino->SetPivotXTile(TET_START_X);
-	m_tetromino->SetPivotYTile(TET_START_Y);
-	m_tetromino->SetShape(I);
+template <class BoardType>
+void TetrominoController<BoardType>::HardDropTetromino() {
+	m_tetromino->SetPivotYTile(m_tetromino->GetPivotYTile() + GetDropDistance());
 }
 
 /*
 ==================
-Attempts a wall kick; tries 1 left, then 1 right, and gives
-up if neither of these are valid positions
+Attempts to rotate the Tetromino with Super Rotation System wall
+kicks - tries the rotated Tetromino at each of the kick offsets
+for this rotation in turn, and moves it to the first one it fits
+at. If it fits at none of them, it is left as it was
+
+Parameters:
+>> direction	CLOCKWISE or ANTICLOCKWISE
 
 Returns:
->> True if a wall kick was performed successfully, false if
+>> True if the Tetromino was rotated successfully, false if
    not
 ==================
 */
-bool TetrominoController::WallKickTetromino() {
-	// Try moving 1 to the left
-	m_tetromino->SetPivotXTile(m_tetromino->GetPivotXTile() - 1);
-	if (IsValidTetrominoPosition()) {
-		return true;
-	}
-	// Try moving 1 to the right
-	else {
-		m_tetromino->SetPivotXTile(m_tetromino->GetPivotXTile() + 2);
-		if (IsValidTetrominoPosition()) {
+template <class BoardType>
+bool TetrominoController<BoardType>::RotateTetromino(int direction) {
+	int rotation = m_tetromino->GetRotation();
+	int newRotation = GetRotatedState(rotation, direction);
+	int xTile = m_tetromino->GetPivotXTile();
+	int yTile = m_tetromino->GetPivotYTile();
+
+	for (int i = 0; i < SRS_KICK_COUNT; i++) {
+		int dxTile, dyTile;
+		GetKickOffset(m_tetromino->GetShape(), rotation, direction, i, &dxTile, &dyTile);
+		int kickedX = xTile + dxTile;
+		int kickedY = yTile + dyTile;
+
+		if (!IsColliding(newRotation, kickedX, kickedY)) {
+			if (direction == CLOCKWISE) {
+				m_tetromino->Rotate();
+			}
+			else {
+				m_tetromino->ReverseRotate();
+			}
+			m_tetromino->SetPivotXTile(kickedX);
+			m_tetromino->SetPivotYTile(kickedY);
 			return true;
 		}
 	}
-	// If none of that worked, set position back and give up
-	m_tetromino->SetPivotXTile(m_tetromino->GetPivotXTile() - 1);
 	return false;
 }
 
+/*
+==================
+Resets the Tetromino to its starting position and
+resets its shape
+==================
+*/
+template <class BoardType>
+void TetrominoController<BoardType>::ResetTetromino()
+{
+	m_tetromino->SetPivotXTile((BoardType::WIDTH - 1) / 2);
+	m_tetromino->SetPivotYTile(TET_START_Y);
+	m_tetromino->SetShape(I);
+}
+
 /*
 ==================
 Check whether movement in a given direction is possible
@@ -154,121 +158,109 @@ Returns:
    if not
 ==================
 */
-bool TetrominoController::IsValidMovement(int direction) {
-	int yTile;
-	int xTile;
+template <class BoardType>
+bool TetrominoController<BoardType>::IsValidMovement(int direction) {
+	int rotation = m_tetromino->GetRotation();
+	int xTile = m_tetromino->GetPivotXTile();
+	int yTile = m_tetromino->GetPivotYTile();
 
 	switch (direction) {
 		case DOWN:
-			for (int i = 0; i < TET_TEMPLATE_SIZE; i++) {
-				for (int j = 0; j < TET_TEMPLATE_SIZE; j++) {
-					// Each board tile of the template
-					yTile = m_tetromino->GetYTile(i);
-					xTile = m_tetromino->GetXTile(j);
+			return !IsColliding(rotation, xTile, yTile + 1);
+		case LEFT:
+			return !IsColliding(rotation, xTile - 1, yTile);
+		case RIGHT:
+			return !IsColliding(rotation, xTile + 1, yTile);
+		default:
+			return false;
+	}
+}
 
-					if (m_tetromino->GetTemplate(j, i) == TET ||
-						m_tetromino->GetTemplate(j, i) == TET_PIVOT) {
-						// Bottom of board reached
-						if (yTile + 1 == BOARD_HEIGHT) {
-							return false;
-						}
-						// If Tetromino is at most 1 block above the board,
-						// and the tile below is filled
-						else if (yTile >= -1 && m_board->IsTileFilled(xTile, yTile + 1)) {
-							return false;
-						}
-					}
-				}
-			}
-			return true;
-			break;
+/*
+==================
+The collision test that all movement, rotation and wall kicks go
+through. Checks whether the player Tetromino's shape, in a given
+rotation with its pivot on a given tile, would overlap a wall, the
+floor or a filled tile. Each row of the shape is shifted into place
+and tested against the board row in one go. Rows above the board
+only collide with the walls
 
-		case LEFT:
-			for (int i = 0; i < TET_TEMPLATE_SIZE; i++) {
-				for (int j = 0; j < TET_TEMPLATE_SIZE; j++) {
-					// Each board tile of the template
-					yTile = m_tetromino->GetYTile(i);
-					xTile = m_tetromino->GetXTile(j);
+Parameters:
+>> rotation	Rotation state to test (0 to 3)
+>> xTile	Horizontal tile for the pivot
+>> yTile	Vertical tile for the pivot
 
-					if (m_tetromino->GetTemplate(j, i) == TET ||
-						m_tetromino->GetTemplate(j, i) == TET_PIVOT) {
-						// Left border reached
-						if (xTile - 1 == -1) {
-							return false;
-						}
-						// If tile is actually within the board, and the tile to the left
-						// is filled
-						else if (yTile >= 0 && m_board->IsTileFilled(xTile - 1, yTile)) {
-							return false;
-						}
-					}
-				}
-			}
-			return true;
-			break;
+Returns:
+>> True if the Tetromino would collide there, false if it fits
+==================
+*/
+template <class BoardType>
+bool TetrominoController<BoardType>::IsColliding(int rotation, int xTile, int yTile) {
+	const TetrominoState& state = Tetromino::s_states.states[m_tetromino->GetShape()][rotation];
+	int left = xTile + state.minX;
+	int top = yTile + state.minY;
 
-		case RIGHT:
-			for (int i = 0; i < TET_TEMPLATE_SIZE; i++) {
-				for (int j = 0; j < TET_TEMPLATE_SIZE; j++) {
-					// Each board tile of the template
-					yTile = m_tetromino->GetYTile(i);
-					xTile = m_tetromino->GetXTile(j);
+	// Walls and floor
+	if (left < 0 || xTile + state.maxX >= BoardType::WIDTH || yTile + state.maxY >= BoardType::HEIGHT) {
+		return true;
+	}
 
-					if (m_tetromino->GetTemplate(j, i) == TET ||
-						m_tetromino->GetTemplate(j, i) == TET_PIVOT) {
-						// Right border reached
-						if (xTile + 1 == BOARD_WIDTH) {
-							return false;
-						}
-						// If tile is actually within the board, and the tile to the right
-						// is filled
-						else if (yTile >= 0 && m_board->IsTileFilled(xTile + 1, yTile)) {
-							return false;
-						}
-					}
-				}
-			}
+	for (int row = 0; row < state.rowCount; row++) {
+		if (top + row >= 0 &&
+			(m_board->GetRowMask(top + row) & ((typename BoardType::RowMask)state.rowMasks[row] << left))) {
 			return true;
-			break;
-
-		default:
-			return false;
+		}
 	}
+	return false;
 }
 
 /*
 ==================
-Checks whether the current position of the Tetromino is
-a valid position on the board (not colliding or out-of-bounds)
+The batched form of IsColliding - tests the player Tetromino's
+shape in a given rotation at every column of a row at once, for
+searching placements. Each tile of the shape shifts the board rows
+it covers onto the columns it would block
+
+Parameters:
+>> rotation	Rotation state to test (0 to 3)
+>> yTile	Vertical tile for the pivot
 
 Returns:
->> True if the current position is valid, false if not
+>> Mask of the columns the Tetromino fits at; bit x is set when it
+   would not collide with its leftmost tile on tile x (so with its
+   pivot on tile x - minX of the rotation state)
 ==================
 */
-bool TetrominoController::IsValidTetrominoPosition() {
-	int xTile;
-	int yTile;
+template <class BoardType>
+uint64_t TetrominoController<BoardType>::GetValidColumns(int rotation, int yTile) {
+	const TetrominoState& state = Tetromino::s_states.states[m_tetromino->GetShape()][rotation];
+	int top = yTile + state.minY;
+	int columnCount = BoardType::WIDTH - (state.maxX - state.minX);
 
-	for (int i = 0; i < TET_TEMPLATE_SIZE; i++) {
-		for (int j = 0; j < TET_TEMPLATE_SIZE; j++) {
-			// Each tile of template
-			yTile = m_tetromino->GetYTile(i);
-			xTile = m_tetromino->GetXTile(j);
+	if (yTile + state.maxY >= BoardType::HEIGHT) {
+		return 0;
+	}
+
+	// Columns that keep the Tetromino inside the walls
+	uint64_t columns = (columnCount == 64) ? ~0ull : (1ull << columnCount) - 1;
 
-			if (m_tetromino->GetTemplate(j, i) == TET ||
-				m_tetromino->GetTemplate(j, i) == TET_PIVOT) {
-				// If tile is outside the bounds of the board
-				if (yTile >= BOARD_HEIGHT || yTile < 0 ||
-					xTile >= BOARD_WIDTH || xTile < 0) {
-					return false;
-				}
-				// If tile is filled
-				else if (m_board->IsTileFilled(xTile, yTile)) {
-					return false;
-				}
+	for (int row = 0; row < state.rowCount; row++) {
+		if (top + row < 0) {
+			continue;
+		}
+		uint64_t boardRow = m_board->GetRowMask(top + row);
+		for (int k = 0; k < TET_TEMPLATE_SIZE; k++) {
+			if (state.rowMasks[row] & (1 << k)) {
+				columns &= ~(boardRow >> k);
 			}
 		}
 	}
+	return columns;
+}
 
-	return true;
-}
\ No newline at end of file
+// ----- Board instantiations -----
+template class TetrominoController<StandardBoard>;
+template class TetrominoController<NarrowBoard>;
+template class TetrominoController<TallBoard>;
+template class TetrominoController<WideBoard>;
+// --------------------------------
@@ -7,38 +7,123 @@
 /*****************************************************************************************/
 
 // ------ Includes -----
-#include <stdlib.h>
-#include <time.h>
+#include <stdint.h>
 #include "Tetromino.h"
 #include "Board.h"
 // ---------------------
 
 // ------ Constants -----
-constexpr auto TET_START_X = BOARD_WIDTH / 2;
-constexpr auto TET_START_Y = -4;
+constexpr auto TET_START_Y = -4;		// Tetrominoes spawn above the board, horizontally centred
+constexpr auto SRS_KICK_COUNT = 5;		// Positions tried for each rotation, including no kick
 // ----------------------
 
 // ------ Enums --------
 enum { DOWN, LEFT, RIGHT };
+enum { CLOCKWISE, ANTICLOCKWISE };
 // ---------------------
 
+// --- Super Rotation System wall kicks ---
+
+// Offsets tried in turn when rotating, for each starting rotation state (spawn, right,
+// 180, left) and direction of rotation; the first one the Tetromino fits at is used.
+// Written as (x, y) with y pointing up, as the tables are normally given, so y is
+// subtracted from the pivot's tile. The O uses these too, but always fits unkicked
+constexpr int8_t SRS_JLSTZ_KICKS[TET_ROTATION_COUNT][2][SRS_KICK_COUNT][2]
+										= {
+											{	// From spawn
+											{{0, 0}, {-1, 0}, {-1, 1}, {0, -2}, {-1, -2}},		// To right
+											{{0, 0}, {1, 0}, {1, 1}, {0, -2}, {1, -2}},			// To left
+											},
+											{	// From right
+											{{0, 0}, {1, 0}, {1, -1}, {0, 2}, {1, 2}},			// To 180
+											{{0, 0}, {1, 0}, {1, -1}, {0, 2}, {1, 2}},			// To spawn
+											},
+											{	// From 180
+											{{0, 0}, {1, 0}, {1, 1}, {0, -2}, {1, -2}},			// To left
+											{{0, 0}, {-1, 0}, {-1, 1}, {0, -2}, {-1, -2}},		// To right
+											},
+											{	// From left
+											{{0, 0}, {-1, 0}, {-1, -1}, {0, 2}, {-1, 2}},		// To spawn
+											{{0, 0}, {-1, 0}, {-1, -1}, {0, 2}, {-1, 2}},		// To 180
+											}
+											};
+
+constexpr int8_t SRS_I_KICKS[TET_ROTATION_COUNT][2][SRS_KICK_COUNT][2]
+										= {
+											{	// From spawn
+											{{0, 0}, {-2, 0}, {1, 0}, {-2, -1}, {1, 2}},		// To right
+											{{0, 0}, {-1, 0}, {2, 0}, {-1, 2}, {2, -1}},		// To left
+											},
+											{	// From right
+											{{0, 0}, {-1, 0}, {2, 0}, {-1, 2}, {2, -1}},		// To 180
+											{{0, 0}, {2, 0}, {-1, 0}, {2, 1}, {-1, -2}},		// To spawn
+											},
+											{	// From 180
+											{{0, 0}, {2, 0}, {-1, 0}, {2, 1}, {-1, -2}},		// To left
+											{{0, 0}, {1, 0}, {-2, 0}, {1, -2}, {-2, 1}},		// To right
+											},
+											{	// From left
+											{{0, 0}, {1, 0}, {-2, 0}, {1, -2}, {-2, 1}},		// To spawn
+											{{0, 0}, {-2, 0}, {1, 0}, {-2, -1}, {1, 2}},		// To 180
+											}
+											};
+
+/*
+==================
+Get the rotation state a Tetromino turns to
+
+Parameters:
+>> rotation		Rotation state it starts in (0 to 3)
+>> direction	CLOCKWISE or ANTICLOCKWISE
+==================
+*/
+inline int GetRotatedState(int rotation, int direction) {
+	return (direction == CLOCKWISE) ? (rotation + 1) % TET_ROTATION_COUNT
+									: (rotation + TET_ROTATION_COUNT - 1) % TET_ROTATION_COUNT;
+}
+
+/*
+==================
+Get one of the kick offsets tried when rotating, from the table
+for the Tetromino's shape. Shared by TetrominoController and the
+batched games, so both always kick the same way
+
+Parameters:
+>> shape		The Tetromino's shape
+>> rotation		Rotation state it starts in (0 to 3)
+>> direction	CLOCKWISE or ANTICLOCKWISE
+>> kick			Which offset, in the order they are tried
+>> dxTile		Set to the tiles to move right
+>> dyTile		Set to the tiles to move down
+==================
+*/
+inline void GetKickOffset(int shape, int rotation, int direction, int kick, int* dxTile, int* dyTile) {
+	const int8_t* offset = (shape == I) ? SRS_I_KICKS[rotation][direction][kick]
+										: SRS_JLSTZ_KICKS[rotation][direction][kick];
+	*dxTile = offset[0];
+	*dyTile = -offset[1];
+}
+// ----------------------------------------
+
 #pragma once
+template <class BoardType>
 class TetrominoController
 {
 	public:
-		TetrominoController(Board *board);
-		~TetrominoController();
+		TetrominoController(BoardType *board, Tetromino* tetromino);
 		Tetromino* GetTetromino();
 		void SpawnTetromino(int shape, int color);
 		bool IsValidMovement(int direction);
+		bool IsColliding(int rotation, int xTile, int yTile);
+		uint64_t GetValidColumns(int rotation, int yTile);
 		void MoveTetromino(int direction);
-		bool RotateTetromino();
+		int GetDropDistance();
+		void HardDropTetromino();
+		bool RotateTetromino(int direction);
 		void ResetTetromino();
 
 	private:
-		Tetromino* m_tetromino;
-		Board* m_board;
-		bool IsValidTetrominoPosition();
-		bool WallKickTetromino();
+		Tetromino* m_tetromino;		// Owned by the game's state, so that it is saved with it
+		BoardType* m_board;
 };
 
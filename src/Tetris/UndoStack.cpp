@@ -0,0 +1,140 @@
+/*****************************************************************************************
+/* File: UndoStack.cpp
+/* Description: A stack of placements that can be undone, owned by whoever wants to take
+/*				moves back (e.g. a bot trying moves). Each entry only keeps the board rows
+/*				its placement changed, packed one after another in a byte arena
+/*
+/* Rachel Pearson 2022
+/*
+/*****************************************************************************************/
+
+#include "UndoStack.h"
+
+/*
+==================
+Constructor
+
+Parameters:
+>> capacity		Most placements that can be undone; pushing more
+				drops the oldest
+==================
+*/
+template <class BoardType>
+UndoStack<BoardType>::UndoStack(int capacity) {
+	m_capacity = (capacity > 0) ? capacity : 1;
+
+	// One entry more than the capacity, for the space that can be left
+	// unused at the end of the arena when the ring goes back to the start
+	m_arena.resize((size_t)(m_capacity + 1) * MAX_ENTRY_SIZE);
+	m_offsets.resize(m_capacity);
+	Clear();
+}
+
+/*
+==================
+Records a placement that is about to be made, so that it can be
+undone
+
+Parameters:
+>> board		The board the Tetromino is about to be placed on
+>> tet			The Tetromino about to be placed
+>> variables	The game variables to go back to when it is undone
+==================
+*/
+template <class BoardType>
+void UndoStack<BoardType>::Push(BoardType* board, Tetromino* tet, const GameVariables& variables) {
+	EntryHeader header;
+	header.board = board->GetUndoRecord(tet);
+	header.variables = variables;
+
+	int rowCount = header.board.lastRow - header.board.firstRow + 1;
+	size_t size = sizeof(header) + ((rowCount > 0) ? rowCount * BoardType::UNDO_ROW_SIZE : 0);
+
+	if (m_count == m_capacity) {
+		DropOldest();
+	}
+
+	// Go back to the start of the arena if the entry won't fit before the end.
+	// At most m_capacity - 1 entries are left, so there is always at least
+	// MAX_ENTRY_SIZE free between m_head and the oldest entry
+	size_t offset = m_head;
+	if (offset + size > m_arena.size()) {
+		offset = 0;
+	}
+
+	memcpy(&m_arena[offset], &header, sizeof(header));
+	board->SaveRows(header.board, &m_arena[offset + sizeof(header)]);
+	m_offsets[(m_oldest + m_count) % m_capacity] = offset;
+	m_count++;
+	m_head = offset + size;
+}
+
+/*
+==================
+Undoes the most recent placement - puts back the board rows it
+changed and the game variables pushed with it
+
+Parameters:
+>> board		The board the placement was made on
+>> variables	Set to the game variables from before the placement
+
+Returns:
+>> True if a placement was undone, false if there were none left
+==================
+*/
+template <class BoardType>
+bool UndoStack<BoardType>::Pop(BoardType* board, GameVariables* variables) {
+	if (m_count == 0) {
+		return false;
+	}
+
+	size_t offset = m_offsets[(m_oldest + m_count - 1) % m_capacity];
+	EntryHeader header;
+	memcpy(&header, &m_arena[offset], sizeof(header));
+	board->RestoreRows(header.board, &m_arena[offset + sizeof(header)]);
+	*variables = header.variables;
+
+	m_head = offset;
+	m_count--;
+	if (m_count == 0) {
+		Clear();
+	}
+	return true;
+}
+
+/*
+==================
+Drops every entry, e.g. when the game they were for is reset
+==================
+*/
+template <class BoardType>
+void UndoStack<BoardType>::Clear() {
+	m_oldest = 0;
+	m_count = 0;
+	m_head = 0;
+}
+
+/*
+==================
+Drops the oldest entry; its bytes are written over by later entries
+==================
+*/
+template <class BoardType>
+void UndoStack<BoardType>::DropOldest() {
+	m_oldest = (m_oldest + 1) % m_capacity;
+	m_count--;
+}
+
+// ------ Getters & Setters -----
+template <class BoardType>
+int UndoStack<BoardType>::GetCount() {
+	return m_count;
+}
+// ------------------------------
+
+// ----- Board instantiations -----
+template class UndoStack<StandardBoard>;
+template class UndoStack<NarrowBoard>;
+template class UndoStack<TallBoard>;
+template class UndoStack<WideBoard>;
+// --------------------------------
@@ -0,0 +1,62 @@
+/*****************************************************************************************
+/* File: UndoStack.h
+/* Description: A stack of placements that can be undone, owned by whoever wants to take
+/*				moves back (e.g. a bot trying moves). Each entry only keeps the board rows
+/*				its placement changed, packed one after another in a byte arena
+/*
+/* Rachel Pearson 2022
+/*
+/*****************************************************************************************/
+
+// ------ Includes -----
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+#include "Board.h"
+#include "GameState.h"
+// ---------------------
+
+// ------ Constants -----
+constexpr auto UNDO_STACK_SIZE = 64;		// Placements that can be undone by default; older ones are dropped
+// ----------------------
+
+#pragma once
+
+// A game only records placements while an undo stack is attached to it with
+// Game::SetUndoStack, so games that never undo pay nothing for it.
+//
+// Each entry is a header - the board's UndoRecord and the game variables to go
+// back to - followed by UNDO_ROW_SIZE bytes for each row saved. The arena is
+// allocated once, big enough for the capacity's worth of the largest entries,
+// and used as a ring: entries are written one after another from m_head, going
+// back to the start when one won't fit before the end, and the oldest entry is
+// dropped when the stack is full. Pushing and popping never allocate or move
+// entries
+template <class BoardType>
+class UndoStack
+{
+	public:
+		UndoStack(int capacity = UNDO_STACK_SIZE);
+		void Push(BoardType* board, Tetromino* tet, const GameVariables& variables);
+		bool Pop(BoardType* board, GameVariables* variables);
+		void Clear();
+		int GetCount();
+
+	private:
+		struct EntryHeader {
+			typename BoardType::UndoRecord board;
+			GameVariables variables;
+		};
+
+		// Size of an entry that saves every row of the board
+		static constexpr size_t MAX_ENTRY_SIZE = sizeof(EntryHeader) + BoardType::HEIGHT * BoardType::UNDO_ROW_SIZE;
+
+		int m_capacity;
+		std::vector<uint8_t> m_arena;		// Entries, in a ring
+		std::vector<size_t> m_offsets;		// Where each entry starts in m_arena, in a ring of m_capacity
+		int m_oldest;						// Index in m_offsets of the oldest entry
+		int m_count;						// Entries in the stack
+		size_t m_head;						// Where the next entry goes in m_arena
+
+		void DropOldest();
+};
@@ -13,13 +13,35 @@
 /*
 ==================
 Constructor
-Initialises objects, including Graphics
+Initialises objects, including Graphics, with the screen sized
+to fit a board of the given size
+
+Parameters:
+>> boardWidth	Width of the board in tiles
+>> boardHeight	Height of the board in tiles
 ==================
 */
-View::View() {
-	graphics = new Graphics(SCREEN_WIDTH, SCREEN_HEIGHT);
-	nextTet = new Tetromino(-1, -1);
-	storedTet = new Tetromino(-1, -1);
+View::View(int boardWidth, int boardHeight) {
+	m_boardWidth = boardWidth;
+	m_boardHeight = boardHeight;
+
+	m_tileSize = TILE_SIZE;
+	if (m_tileSize * boardWidth > MAX_BOARD_PIXEL_WIDTH) {
+		m_tileSize = MAX_BOARD_PIXEL_WIDTH / boardWidth;
+	}
+	if (m_tileSize * boardHeight > MAX_BOARD_PIXEL_HEIGHT) {
+		m_tileSize = MAX_BOARD_PIXEL_HEIGHT / boardHeight;
+	}
+
+	m_screenWidth = boardWidth * m_tileSize + (BORDER_SIZE * 2) + GUI_WIDTH;
+	m_screenHeight = boardHeight * m_tileSize + (BORDER_SIZE * 2);
+	if (m_screenHeight < MIN_SCREEN_HEIGHT) {
+		m_screenHeight = MIN_SCREEN_HEIGHT;
+	}
+
+	graphics = new Graphics(m_screenWidth, m_screenHeight);
+	m_pieceQueue = NULL;
+	storedTet = Tetromino(-1, -1);
 }
 
 /*
@@ -29,19 +51,22 @@ Destructor
 */
 View::~View() {
 	delete(graphics);
-	delete(nextTet);
-	delete(storedTet);
 }
 
 // ------ Getters & Setters -----
-void View::SetNextTetromino(int shape, int color) {
-	nextTet->SetShape(shape);
-	nextTet->SetColor(color);
+/*
+==================
+Sets the queue of upcoming Tetrominoes to draw from; it is read
+in place every time the GUI is drawn, so only needs setting once
+==================
+*/
+void View::SetPieceQueue(PieceQueue* pieceQueue) {
+	m_pieceQueue = pieceQueue;
 }
 
 void View::SetStoredTetromino(int shape, int color) {
-	storedTet->SetShape(shape);
-	storedTet->SetColor(color);
+	storedTet.SetShape(shape);
+	storedTet.SetColor(color);
 }
 // ------------------------------
 
@@ -52,10 +77,11 @@ Draws a block sprite to the screen
 Parameters:
 >> xPos		Horizontal position to draw the block at
 >> yPos		Vertical position to draw the block at
+>> size		Width/height of the block
 >> color	Color of the block to draw
 ==================
 */
-void View::DrawBlock(int xPos, int yPos, int color) {
+void View::DrawBlock(int xPos, int yPos, int size, int color) {
 	int sprite;
 
 	switch (color) {
@@ -82,7 +108,22 @@ void View::DrawBlock(int xPos, int yPos, int color) {
 			break;
 	}
 
-	graphics->DrawSprite(xPos, yPos, TILE_SIZE, TILE_SIZE, sprite);
+	graphics->DrawSprite(xPos, yPos, size, size, sprite);
+}
+
+/*
+==================
+Draws one tile of the ghost Tetromino - a grey outline of a block
+
+Parameters:
+>> xPos		Horizontal position to draw the block at
+>> yPos		Vertical position to draw the block at
+>> size		Width/height of the block
+==================
+*/
+void View::DrawGhostBlock(int xPos, int yPos, int size) {
+	graphics->DrawRectangle(xPos, yPos, size, size, graphics->GREY);
+	graphics->DrawRectangle(xPos + 2, yPos + 2, size - 4, size - 4, graphics->BLACK);
 }
 
 /*
@@ -110,8 +151,8 @@ to the middle of the screen
 ==================
 */
 void View::DrawStartText() {
-	int xPos = (SCREEN_WIDTH - START_TXT_WIDTH) / 2;
-	int yPos = (SCREEN_HEIGHT - TXT_SIZE) / 2;
+	int xPos = (m_screenWidth - START_TXT_WIDTH) / 2;
+	int yPos = (m_screenHeight - TXT_SIZE) / 2;
 
 	graphics->DrawSprite(xPos, yPos, START_TXT_WIDTH, TXT_SIZE, GAME_START_TXT);
 }
@@ -130,14 +171,31 @@ void View::DrawGameOverText(int finalScore) {
 	int padding = 35;
 	int spacing = 12;
 
-	int xPos = (SCREEN_WIDTH - GAME_OVER_TXT_WIDTH) / 2;
-	int yPos = (SCREEN_HEIGHT - TXT_SIZE) / 2;
+	int xPos = (m_screenWidth - GAME_OVER_TXT_WIDTH) / 2;
+	int yPos = (m_screenHeight - TXT_SIZE) / 2;
 
 	graphics->DrawSprite(xPos, yPos, GAME_OVER_TXT_WIDTH, TXT_SIZE, GAME_OVER_TXT);
 	DrawScoreText(xPos, yPos + padding);
 	DrawScore(xPos + SCORE_TXT_WIDTH + spacing, yPos + padding, finalScore);
 }
 
+/*
+==================
+Draws two bars in the middle of the board, to show that the game
+is paused
+==================
+*/
+void View::DrawPauseSymbol() {
+	int barWidth = m_tileSize;
+	int barHeight = m_tileSize * 3;
+
+	int xPos = BORDER_SIZE + (m_boardWidth * m_tileSize) / 2;
+	int yPos = BORDER_SIZE + (m_boardHeight * m_tileSize - barHeight) / 2;
+
+	graphics->DrawRectangle(xPos - barWidth - barWidth / 2, yPos, barWidth, barHeight, graphics->WHITE);
+	graphics->DrawRectangle(xPos + barWidth / 2, yPos, barWidth, barHeight, graphics->WHITE);
+}
+
 /*
 ==================
 Draws the text that says "SCORE: "
@@ -203,68 +261,81 @@ void View::DrawScore(int xPos, int yPos, int score) {
 
 /*
 ==================
-Draws the next Tetromino or the stored Tetromino
+Draws a Tetromino outside the board, such as the next or the
+stored Tetromino
 
 Parameters:
 >> xPos		Horizontal position to draw the Tetromino at
 >> yPos		Vertical position to draw the Tetromino at
->> type		The type of Tetromino to draw - the next one or the
-			stored one
+>> tet		The Tetromino to draw
+>> tileSize	Size of each of its tiles on screen
 ==================
 */
-void View::DrawTetromino(int xPos, int yPos, int type) {
-	Tetromino* tet;
-	if (type == NEXT_TET) {
-		tet = nextTet;
-	}
-	else {
-		tet = storedTet;
-	}
-	for (int i = 0; i < TET_TEMPLATE_SIZE; i++) {
-		for (int j = 0; j < TET_TEMPLATE_SIZE; j++) {
-			if (tet->GetTemplate(j, i) == TET ||
-				tet->GetTemplate(j, i) == TET_PIVOT) {
-				DrawBlock((xPos + TILE_SIZE * j), (yPos + TILE_SIZE * i), 
-						   tet->GetColor());
-			}
-		}
+void View::DrawTetromino(int xPos, int yPos, Tetromino* tet, int tileSize) {
+	for (int i = 0; i < TET_TILE_COUNT; i++) {
+		DrawBlock((xPos + tileSize * tet->GetTemplateX(i)), 
+				  (yPos + tileSize * tet->GetTemplateY(i)),
+				  tileSize, tet->GetColor());
 	}
 }
 
 /*
 ==================
-Draws the board - filled tiles, Tetromino tiles, and the bordered
-box surrounding the board
+Draws the board - filled tiles, then the ghost of where the
+falling Tetromino will land, then the falling Tetromino over
+the top of them
 
 Parameters:
 >> board		The board to draw
->> tetColor		The color of the current Tetromino on the board
+>> tet			The falling Tetromino, which is not stored in
+				the board
+>> ghost		The falling Tetromino moved to where it would
+				land, or NULL to not draw a ghost
 ==================
 */
-void View::DrawBoard(Board* board, int tetColor) {
+template <class BoardType>
+void View::DrawBoard(BoardType* board, Tetromino* tet, Tetromino* ghost) {
 	int xPos = 0;
 	int yPos = 0;
 
-	for (int i = 0; i < BOARD_HEIGHT; i++) {
-		for (int j = 0; j < BOARD_WIDTH; j++) {
-			xPos = j * TILE_SIZE + BORDER_SIZE;
-			yPos = i * TILE_SIZE + BORDER_SIZE;
+	for (int i = 0; i < BoardType::HEIGHT; i++) {
+		for (int j = 0; j < BoardType::WIDTH; j++) {
+			xPos = j * m_tileSize + BORDER_SIZE;
+			yPos = i * m_tileSize + BORDER_SIZE;
 			if (board->GetTile(j, i) != EMPTY) {
-				int color;
-				if (board->GetTile(j, i) == TET ||
-					board->GetTile(j, i) == TET_PIVOT) {
-					color = tetColor;
-				}
-				else {
-					color = board->GetTile(j, i);
-				}
-				DrawBlock(xPos, yPos, color);
+				DrawBlock(xPos, yPos, m_tileSize, board->GetTile(j, i));
 			}
+		}
+	}
+
+	// Outline where the falling Tetromino will land
+	if (ghost != NULL) {
+		for (int i = 0; i < TET_TILE_COUNT; i++) {
+			if (ghost->GetTileY(i) >= 0) {
+				xPos = ghost->GetTileX(i) * m_tileSize + BORDER_SIZE;
+				yPos = ghost->GetTileY(i) * m_tileSize + BORDER_SIZE;
+				DrawGhostBlock(xPos, yPos, m_tileSize);
+			}
+		}
+	}
 
+	// Overlay the falling Tetromino, skipping tiles above the board
+	for (int i = 0; i < TET_TILE_COUNT; i++) {
+		if (tet->GetTileY(i) >= 0) {
+			xPos = tet->GetTileX(i) * m_tileSize + BORDER_SIZE;
+			yPos = tet->GetTileY(i) * m_tileSize + BORDER_SIZE;
+			DrawBlock(xPos, yPos, m_tileSize, tet->GetColor());
 		}
 	}
 }
 
+// ----- Board instantiations -----
+template void View::DrawBoard<StandardBoard>(StandardBoard* board, Tetromino* tet, Tetromino* ghost);
+template void View::DrawBoard<NarrowBoard>(NarrowBoard* board, Tetromino* tet, Tetromino* ghost);
+template void View::DrawBoard<TallBoard>(TallBoard* board, Tetromino* tet, Tetromino* ghost);
+template void View::DrawBoard<WideBoard>(WideBoard* board, Tetromino* tet, Tetromino* ghost);
+// --------------------------------
+
 /*
 ==================
 Draws all GUI - everything on the screen other than the board
@@ -274,9 +345,9 @@ Parameters:
 ==================
 */
 void View::DrawGUI(int currentScore) {
-	int boardWidth = BOARD_WIDTH * TILE_SIZE;
-	int boardHeight = BOARD_HEIGHT * TILE_SIZE;
-	int totalBoardWidth = BOARD_WIDTH * TILE_SIZE + (BORDER_SIZE * 2);
+	int boardWidth = m_boardWidth * m_tileSize;
+	int boardHeight = m_boardHeight * m_tileSize;
+	int totalBoardWidth = m_boardWidth * m_tileSize + (BORDER_SIZE * 2);
 	int hTetrominoPadding = (TET_TEMPLATE_SIZE * TILE_SIZE) / 3;
 	int vTetrominoPadding = (TET_TEMPLATE_SIZE * TILE_SIZE) / 4;
 	int hPadding = 50;
@@ -293,24 +364,40 @@ void View::DrawGUI(int currentScore) {
 
 	// Draw next tetromino box
 	DrawGUIBox		(totalBoardWidth + hPadding,
-					(SCREEN_HEIGHT / 2) - GUI_BOX_SIZE - vPadding,
+					(m_screenHeight / 2) - GUI_BOX_SIZE - vPadding,
 					GUI_BOX_SIZE, GUI_BOX_SIZE);
 	DrawNextText	(totalBoardWidth + hPadding + (GUI_BOX_SIZE / 2) - (NEXT_TXT_WIDTH / 2),
-					(SCREEN_HEIGHT / 2) - GUI_BOX_SIZE - vPadding + TXT_SIZE);
-	DrawTetromino	(totalBoardWidth + hPadding + (GUI_BOX_SIZE / 2) - hTetrominoPadding,
-					(SCREEN_HEIGHT / 2) - (GUI_BOX_SIZE / 2) - vPadding - vTetrominoPadding,
-					NEXT_TET);
+					(m_screenHeight / 2) - GUI_BOX_SIZE - vPadding + TXT_SIZE);
+	if (m_pieceQueue != NULL) {
+		Tetromino nextTet = Tetromino(m_pieceQueue->GetShape(0), m_pieceQueue->GetColor(0));
+		DrawTetromino	(totalBoardWidth + hPadding + (GUI_BOX_SIZE / 2) - hTetrominoPadding,
+						(m_screenHeight / 2) - (GUI_BOX_SIZE / 2) - vPadding - vTetrominoPadding,
+						&nextTet, TILE_SIZE);
+	}
+
+	// Draw the Tetrominoes after the next one in a column beside it
+	int previewX = totalBoardWidth + hPadding + GUI_BOX_SIZE + (BORDER_SIZE * 2) + spacing;
+	int previewY = (m_screenHeight / 2) - GUI_BOX_SIZE - vPadding;
+	DrawGUIBox		(previewX, previewY, PREVIEW_BOX_WIDTH, GUI_BOX_SIZE);
+	if (m_pieceQueue != NULL) {
+		for (int i = 1; i < PREVIEW_COUNT; i++) {
+			Tetromino previewTet = Tetromino(m_pieceQueue->GetShape(i), m_pieceQueue->GetColor(i));
+			DrawTetromino	(previewX + BORDER_SIZE,
+							previewY + BORDER_SIZE + (i - 1) * PREVIEW_SLOT_HEIGHT + PREVIEW_TILE_SIZE / 2,
+							&previewTet, PREVIEW_TILE_SIZE);
+		}
+	}
 
 	// Draw stored tetromino box
 	DrawGUIBox		(totalBoardWidth + hPadding, 
-					(SCREEN_HEIGHT / 2) + vPadding, 
+					(m_screenHeight / 2) + vPadding, 
 					GUI_BOX_SIZE, GUI_BOX_SIZE);
 	DrawStoredText	(totalBoardWidth + hPadding + (GUI_BOX_SIZE / 2) - (STORED_TXT_WIDTH / 2),
-					(SCREEN_HEIGHT / 2) + vPadding + vTextPadding);
-	if (storedTet->GetShape() != -1) {
+					(m_screenHeight / 2) + vPadding + vTextPadding);
+	if (storedTet.GetShape() != -1) {
 		DrawTetromino	(totalBoardWidth + hPadding + (GUI_BOX_SIZE / 2) - hTetrominoPadding,
-						(SCREEN_HEIGHT / 2) + (GUI_BOX_SIZE / 2) + vPadding - vTetrominoPadding,
-						STORED_TET);
+						(m_screenHeight / 2) + (GUI_BOX_SIZE / 2) + vPadding - vTetrominoPadding,
+						&storedTet, TILE_SIZE);
 	}
 }
 
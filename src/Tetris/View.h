@@ -10,12 +10,15 @@
 #include <stack>
 #include "Graphics.h"
 #include "Board.h"
+#include "Randomizer.h"
 // ---------------------
 
 // ------ Constants -----
 constexpr auto BORDER_SIZE = 5;
-constexpr auto SCREEN_WIDTH = BOARD_WIDTH * TILE_SIZE + (BORDER_SIZE * 2) + 300;
-constexpr auto SCREEN_HEIGHT = BOARD_HEIGHT * TILE_SIZE + (BORDER_SIZE * 2);
+constexpr auto GUI_WIDTH = 380;								// Space to the right of the board
+constexpr auto MIN_SCREEN_HEIGHT = 20 * TILE_SIZE + (BORDER_SIZE * 2);	// Fits the GUI boxes
+constexpr auto MAX_BOARD_PIXEL_WIDTH = 1200;				// Tiles shrink to keep large boards
+constexpr auto MAX_BOARD_PIXEL_HEIGHT = 900;				// within these sizes
 
 constexpr auto TXT_SIZE = 25;
 
@@ -27,37 +30,46 @@ constexpr auto STORED_TXT_WIDTH = 7 * TXT_SIZE;
 
 constexpr auto GUI_BOX_SIZE = 200;
 
-// ----------------------
+// The Tetrominoes after the next one are drawn smaller, in a column beside it
+constexpr auto PREVIEW_TILE_SIZE = TILE_SIZE / 2;
+constexpr auto PREVIEW_BOX_WIDTH = TET_TEMPLATE_SIZE * PREVIEW_TILE_SIZE;
+constexpr auto PREVIEW_SLOT_HEIGHT = GUI_BOX_SIZE / (PREVIEW_COUNT - 1);
 
-// ------ Enums --------
-enum { NEXT_TET, STORED_TET };
-// ---------------------
+// ----------------------
 
 #pragma once
 class View
 {
 	public:
-		View();
+		View(int boardWidth, int boardHeight);
 		~View();
-		void SetNextTetromino(int shape, int color);
+		void SetPieceQueue(PieceQueue* pieceQueue);
 		void SetStoredTetromino(int shape, int color);
-		void DrawBoard(Board* board, int tetColor);
+		template <class BoardType>
+		void DrawBoard(BoardType* board, Tetromino* tet, Tetromino* ghost);
 		void DrawStartText();
 		void DrawGameOverText(int finalScore);
+		void DrawPauseSymbol();
 		void DrawGUI(int currentScore);
 		void Clear();
 		void Update();
 
 	private:
 		Graphics* graphics;
-		Tetromino* nextTet;			// The next Tetromino's values, stored to be drawn
-		Tetromino* storedTet;		// The stored Tetromino's values, stored to be drawn
-		void DrawBlock(int xPos, int yPos, int sprite);
+		int m_boardWidth;			// Board size in tiles
+		int m_boardHeight;
+		int m_tileSize;				// Size of one board tile on screen
+		int m_screenWidth;
+		int m_screenHeight;
+		PieceQueue* m_pieceQueue;	// The game's upcoming Tetrominoes, read when drawn
+		Tetromino storedTet;		// The stored Tetromino's values, stored to be drawn
+		void DrawBlock(int xPos, int yPos, int size, int sprite);
+		void DrawGhostBlock(int xPos, int yPos, int size);
 		void DrawScoreText(int xPos, int yPos);
 		void DrawNextText(int xPos, int yPos);
 		void DrawStoredText(int xPos, int yPos);
 		void DrawGUIBox(int xPos, int yPos, int width, int height);
 		void DrawScore(int xPos, int yPos, int score);
-		void DrawTetromino(int xPos, int yPos, int type);
+		void DrawTetromino(int xPos, int yPos, Tetromino* tet, int tileSize);
 };
 
@@ -0,0 +1,16 @@
+/*****************************************************************************************
+/* File: Zobrist.cpp
+/* Description: Keys for Zobrist hashing of the game state - one random 64-bit key per
+/*				board tile, XORed together for every filled tile, plus keys for the falling,
+/*				next and stored Tetrominoes. Keys are generated at compile time, so hashes
+/*				are the same on every platform and in every build
+/*
+/* Rachel Pearson 2022
+/*
+/*****************************************************************************************/
+
+#include "Zobrist.h"
+
+// Still worked out at compile time, as BuildZobristTable is constexpr. Defined as
+// const rather than extern constexpr, which MSVC won't link without /Zc:externConstexpr
+const ZobristTable ZOBRIST_KEYS = BuildZobristTable();
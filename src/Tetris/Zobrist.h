@@ -0,0 +1,85 @@
+/*****************************************************************************************
+/* File: Zobrist.h
+/* Description: Keys for Zobrist hashing of the game state - one random 64-bit key per
+/*				board tile, XORed together for every filled tile, plus keys for the falling,
+/*				next and stored Tetrominoes. Keys are generated at compile time, so hashes
+/*				are the same on every platform and in every build
+/*
+/* Rachel Pearson 2022
+/*
+/*****************************************************************************************/
+
+// ------ Includes -----
+#include <stdint.h>
+// ---------------------
+
+// ------ Constants -----
+constexpr auto ZOBRIST_TABLE_SIZE = 64;		// Keys cover boards up to 64 x 64
+
+// Salts keeping the different kinds of Tetromino key apart
+constexpr uint64_t ZOBRIST_FALLING_SALT = 0x1000000000000000ull;
+constexpr uint64_t ZOBRIST_NEXT_SALT = 0x2000000000000000ull;
+constexpr uint64_t ZOBRIST_STORED_SALT = 0x3000000000000000ull;
+// ----------------------
+
+#pragma once
+
+/*
+==================
+SplitMix64 - scrambles a 64-bit value into a well distributed
+64-bit key
+==================
+*/
+constexpr uint64_t SplitMix64(uint64_t value) {
+	value += 0x9E3779B97F4A7C15ull;
+	value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+	value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+	return value ^ (value >> 31);
+}
+
+struct ZobristTable {
+	uint64_t tiles[ZOBRIST_TABLE_SIZE][ZOBRIST_TABLE_SIZE];	// Indexed by [yTile][xTile]
+};
+
+/*
+==================
+Builds the key of every board tile
+==================
+*/
+constexpr ZobristTable BuildZobristTable() {
+	ZobristTable table = {};
+
+	for (int i = 0; i < ZOBRIST_TABLE_SIZE; i++) {
+		for (int j = 0; j < ZOBRIST_TABLE_SIZE; j++) {
+			table.tiles[i][j] = SplitMix64((uint64_t)(i * ZOBRIST_TABLE_SIZE + j));
+		}
+	}
+	return table;
+}
+
+// The tile keys, defined once in Zobrist.cpp
+extern const ZobristTable ZOBRIST_KEYS;
+
+/*
+==================
+Get the key of a filled tile at a given board position
+==================
+*/
+inline uint64_t ZobristTileKey(int xTile, int yTile) {
+	return ZOBRIST_KEYS.tiles[yTile][xTile];
+}
+
+/*
+==================
+Get the key of a Tetromino in a given state; salt says which
+Tetromino it is (falling, next or stored). A shape of -1 (no
+Tetromino) has a key of 0
+==================
+*/
+inline uint64_t ZobristTetrominoKey(uint64_t salt, int shape, int rotation, int xTile, int yTile) {
+	if (shape < 0) {
+		return 0;
+	}
+	return SplitMix64(salt | ((uint64_t)shape << 24) | ((uint64_t)rotation << 16) |
+					  ((uint64_t)(uint8_t)xTile << 8) | (uint64_t)(uint8_t)yTile);
+}
@@ -0,0 +1,184 @@
+/*****************************************************************************************
+/* File: ArchiveTool.cpp
+/* Description: Packs replay files into an archive, lists what is in one, and seeks to
+/*				a tick of an archived game - timing the seek against playing the game
+/*				from the start, and checking that both end up in the same state
+/*
+/* Rachel Pearson 2022
+/*
+/*****************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include "Game.h"
+#include "Replay.h"
+#include "ReplayArchive.h"
+
+/*
+==================
+Packs replay files into a new archive
+
+Parameters:
+>> path			Archive to write
+>> replayPaths	Replay files to pack
+>> replayCount	Number of replay files
+
+Returns:
+>> 0 on success
+==================
+*/
+static int Pack(const char* path, char** replayPaths, int replayCount) {
+	ReplayArchiveWriter writer;
+	if (!writer.Open(path)) {
+		printf("Could not create %s\n", path);
+		return 1;
+	}
+
+	for (int i = 0; i < replayCount; i++) {
+		ReplayReader replay;
+		if (!replay.Open(replayPaths[i]) || !writer.AddReplay(&replay)) {
+			printf("Skipped %s - not a replay of the current rules on a supported board size\n", replayPaths[i]);
+		}
+	}
+
+	if (!writer.Close()) {
+		printf("Could not write %s\n", path);
+		return 1;
+	}
+	return 0;
+}
+
+/*
+==================
+Prints the index of an archive
+
+Parameters:
+>> archive	The open archive
+
+Returns:
+>> 0 on success
+==================
+*/
+static int List(ReplayArchive* archive) {
+	printf("%d games\n", archive->GetGameCount());
+	for (int i = 0; i < archive->GetGameCount(); i++) {
+		const ArchiveEntry* entry = archive->GetEntry(i);
+		printf("%20llu  %2d x %2d  %9u ticks  %6u keyframes  %8u replay bytes\n",
+			   (unsigned long long)entry->seed, entry->boardWidth, entry->boardHeight,
+			   entry->tickCount, entry->keyframeCount, entry->replaySize);
+	}
+	return 0;
+}
+
+/*
+==================
+Seeks to a tick of an archived game, then plays the same game from
+its first tick to the same place, and prints how long each took
+and whether they agree
+
+Parameters:
+>> archive	The open archive
+>> game		The game's number in the archive
+>> tick		The tick to seek to
+
+Returns:
+>> 0 if the two agree
+==================
+*/
+template <class BoardType>
+static int Seek(ReplayArchive* archive, int game, uint32_t tick) {
+	const ArchiveEntry* entry = archive->GetEntry(game);
+	ReplayReader replay;
+	uint32_t input;
+
+	// Keyframe, then the ticks after it
+	Game<BoardType>* seeked = new Game<BoardType>(0, RANDOMIZER_BAG);
+	auto start = std::chrono::steady_clock::now();
+	if (!archive->Seek(game, tick, seeked, &replay)) {
+		printf("Could not seek - the archive was written by a different build\n");
+		delete seeked;
+		return 1;
+	}
+	double seekSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	// Every tick from the start
+	archive->OpenReplay(game, &replay);
+	Game<BoardType>* played = new Game<BoardType>(entry->seed, replay.GetHeader().randomizerType);
+	start = std::chrono::steady_clock::now();
+	while (replay.GetCursor().tick < tick && replay.NextTick(&input)) {
+		played->Tick(input);
+	}
+	double playSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	printf("Tick %u: score %d, %d pieces, state hash %016llx\n", seeked->GetTickCount(), seeked->GetScore(),
+		   seeked->GetPieceCount(), (unsigned long long)seeked->GetStateHash());
+	printf("Seek:               %10.3f ms\n", seekSeconds * 1000.0);
+	printf("Play from the start:%10.3f ms\n", playSeconds * 1000.0);
+
+	// The state hash covers everything a keyframe restores - timers, score,
+	// piece queue and random numbers as well as the board and pieces
+	bool same = seeked->GetStateHash() == played->GetStateHash() && seeked->GetScore() == played->GetScore() &&
+				seeked->GetTickCount() == played->GetTickCount();
+	if (!same) {
+		printf("Mismatch - playing from the start gave score %d and state hash %016llx at tick %u\n",
+			   played->GetScore(), (unsigned long long)played->GetStateHash(), played->GetTickCount());
+	}
+	delete seeked;
+	delete played;
+	return same ? 0 : 1;
+}
+
+/*
+==================
+Commands:
+	pack <archive> <replay>...
+	list <archive>
+	seek <archive> <seed> <tick>
+==================
+*/
+int main(int argc, char* argv[]) {
+	if (argc >= 4 && strcmp(argv[1], "pack") == 0) {
+		return Pack(argv[2], &argv[3], argc - 3);
+	}
+
+	ReplayArchive archive;
+	if (argc >= 3 && !archive.Open(argv[2])) {
+		printf("Could not open archive %s\n", argv[2]);
+		return 1;
+	}
+	if (argc == 3 && strcmp(argv[1], "list") == 0) {
+		return List(&archive);
+	}
+	if (argc == 5 && strcmp(argv[1], "seek") == 0) {
+		int game = archive.FindGame(strtoull(argv[3], NULL, 10));
+		uint32_t tick = (uint32_t)strtoul(argv[4], NULL, 10);
+		if (game < 0) {
+			printf("No game with seed %s\n", argv[3]);
+			return 1;
+		}
+
+		const ArchiveEntry* entry = archive.GetEntry(game);
+		if (entry->boardWidth == StandardBoard::WIDTH && entry->boardHeight == StandardBoard::HEIGHT) {
+			return Seek<StandardBoard>(&archive, game, tick);
+		}
+		if (entry->boardWidth == NarrowBoard::WIDTH && entry->boardHeight == NarrowBoard::HEIGHT) {
+			return Seek<NarrowBoard>(&archive, game, tick);
+		}
+		if (entry->boardWidth == TallBoard::WIDTH && entry->boardHeight == TallBoard::HEIGHT) {
+			return Seek<TallBoard>(&archive, game, tick);
+		}
+		if (entry->boardWidth == WideBoard::WIDTH && entry->boardHeight == WideBoard::HEIGHT) {
+			return Seek<WideBoard>(&archive, game, tick);
+		}
+		printf("Unsupported board size\n");
+		return 1;
+	}
+
+	printf("Usage:\n");
+	printf("  %s pack <archive> <replay>...\n", argv[0]);
+	printf("  %s list <archive>\n", argv[0]);
+	printf("  %s seek <archive> <seed> <tick>\n", argv[0]);
+	return 1;
+}
@@ -0,0 +1,166 @@
+/*****************************************************************************************
+/* File: BatchBenchmark.cpp
+/* Description: Times BatchGame against looping over the same number of Game objects,
+/*				with the same inputs, and checks that every game ended up the same both ways
+/*
+/* Rachel Pearson 2022
+/*
+/*****************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <chrono>
+#include <vector>
+#include "BatchGame.h"
+
+// ------ Constants -----
+constexpr auto DEFAULT_TICKS = 2000;
+// ----------------------
+
+/*
+==================
+Get the inputs a game presses on a given tick - a cheap hash of
+the two, mostly pressing nothing, sometimes moving or rotating, and
+now and then dropping, plus soft drop held for a stretch of ticks
+every so often. Storing is left out, as BatchGame ignores it
+==================
+*/
+static uint32_t GetInput(int game, int tick) {
+	uint32_t hash = (uint32_t)game * 0x9E3779B1u ^ (uint32_t)tick * 0x85EBCA77u;
+	hash ^= hash >> 15;
+	hash *= 0x2C1B3C6Du;
+	hash ^= hash >> 12;
+
+	uint32_t held = (((uint32_t)game + (uint32_t)tick / 16) % 8 == 0) ? INPUT_SOFT_DROP : 0;
+	switch (hash % 32) {
+		case 0:
+			return held | INPUT_LEFT;
+		case 1:
+			return held | INPUT_RIGHT;
+		case 2:
+			return held | INPUT_ROTATE_CW;
+		case 3:
+			return held | INPUT_ROTATE_ACW;
+		case 4:
+			return held | INPUT_SOFT_DROP;
+		case 5:
+			return held | INPUT_HARD_DROP;
+		case 6:
+			return held | INPUT_LEFT_WALL;
+		case 7:
+			return held | INPUT_RIGHT_WALL;
+		default:
+			return held;
+	}
+}
+
+/*
+==================
+Checks that a game of the batch is in the same state as the Game
+that was played with the same seed and inputs - its board, score,
+pieces placed and player Tetromino
+
+Returns:
+>> True if they are the same
+==================
+*/
+static bool IsSameGame(BatchGame* batch, int index, Game<StandardBoard>* game) {
+	if (batch->IsGameOver(index) != game->IsGameOver() || batch->GetScore(index) != game->GetScore() ||
+		batch->GetPieceCount(index) != game->GetPieceCount()) {
+		return false;
+	}
+	for (int i = 0; i < StandardBoard::HEIGHT; i++) {
+		if (batch->GetRowMask(index, i) != game->GetBoard()->GetRowMask(i)) {
+			return false;
+		}
+	}
+	if (game->IsGameOver()) {
+		return true;
+	}
+
+	Tetromino* tet = game->GetTetromino();
+	return batch->GetShape(index) == tet->GetShape() && batch->GetRotation(index) == tet->GetRotation() &&
+		   batch->GetPivotXTile(index) == tet->GetPivotXTile() && batch->GetPivotYTile(index) == tet->GetPivotYTile();
+}
+
+/*
+==================
+Runs BATCH_SIZE games for the given number of ticks (from the
+first command line argument) both ways, restarting games as they
+end, and prints how long each took. Then checks each game against
+its counterpart, and fails if any differ
+==================
+*/
+int main(int argc, char* argv[]) {
+	int ticks = (argc > 1) ? atoi(argv[1]) : DEFAULT_TICKS;
+	std::vector<uint32_t> inputs(BATCH_SIZE);
+	long long batchPieces = 0;
+	long long gamePieces = 0;
+
+	printf("%d games x %d ticks\n", BATCH_SIZE, ticks);
+
+	// All of the games in lockstep
+	BatchGame* batch = new BatchGame(RANDOMIZER_BAG);
+	auto start = std::chrono::steady_clock::now();
+	for (int tick = 0; tick < ticks; tick++) {
+		for (int game = 0; game < BATCH_SIZE; game++) {
+			inputs[game] = GetInput(game, tick);
+		}
+		batch->Step(inputs.data());
+
+		for (int game = 0; game < BATCH_SIZE; game++) {
+			if (batch->IsGameOver(game)) {
+				batchPieces += batch->GetPieceCount(game);
+				batch->Reset(game, (uint64_t)game + (uint64_t)tick * BATCH_SIZE);
+			}
+		}
+	}
+	double batchSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	for (int game = 0; game < BATCH_SIZE; game++) {
+		batchPieces += batch->GetPieceCount(game);
+	}
+
+	// The same games one at a time, a tick of each in turn
+	std::vector<Game<StandardBoard>*> games(BATCH_SIZE);
+	for (int game = 0; game < BATCH_SIZE; game++) {
+		games[game] = new Game<StandardBoard>((uint64_t)game, RANDOMIZER_BAG);
+	}
+	start = std::chrono::steady_clock::now();
+	for (int tick = 0; tick < ticks; tick++) {
+		for (int game = 0; game < BATCH_SIZE; game++) {
+			if (!games[game]->Tick(GetInput(game, tick))) {
+				gamePieces += games[game]->GetPieceCount();
+				games[game]->Reset((uint64_t)game + (uint64_t)tick * BATCH_SIZE);
+			}
+		}
+	}
+	double gameSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	int differentGames = 0;
+	for (int game = 0; game < BATCH_SIZE; game++) {
+		gamePieces += games[game]->GetPieceCount();
+		if (!IsSameGame(batch, game, games[game])) {
+			if (differentGames == 0) {
+				printf("Game %d differs: score %d vs %d, %d vs %d pieces\n", game, batch->GetScore(game),
+					   games[game]->GetScore(), batch->GetPieceCount(game), games[game]->GetPieceCount());
+			}
+			differentGames++;
+		}
+		delete games[game];
+	}
+	delete batch;
+
+	double gameTicks = (double)ticks * BATCH_SIZE;
+	printf("BatchGame: %8.3f s  %12.0f game ticks/s  %lld pieces\n",
+		   batchSeconds, gameTicks / batchSeconds, batchPieces);
+	printf("Game:      %8.3f s  %12.0f game ticks/s  %lld pieces\n",
+		   gameSeconds, gameTicks / gameSeconds, gamePieces);
+	printf("Speedup:   %8.2fx\n", gameSeconds / batchSeconds);
+	if (differentGames != 0 || batchPieces != gamePieces) {
+		printf("Warning: %d of the games ended up different the two ways\n", differentGames);
+		return 1;
+	}
+	printf("All %d games ended up the same both ways\n", BATCH_SIZE);
+
+	return 0;
+}
@@ -0,0 +1,220 @@
+/*****************************************************************************************
+/* File: Bot.cpp
+/* Description: A simple bot that plays a Game - for each new Tetromino it tries every
+/*				rotation and column, scores the board each would leave, and then presses
+/*				the inputs to get there
+/*
+/* Rachel Pearson 2022
+/*
+/*****************************************************************************************/
+
+#include "Bot.h"
+
+// Score of a placement that ends the game
+constexpr auto BOT_LOSING_SCORE = -1.0e9;
+
+// Ticks the bot spends getting a Tetromino into place before it gives up and drops it
+// where it is, in case a wall or the stack is in the way
+constexpr auto BOT_MAX_PLAN_TICKS = 16;
+
+/*
+==================
+Constructor
+==================
+*/
+template <class BoardType>
+Bot<BoardType>::Bot() {
+	Reset();
+}
+
+/*
+==================
+Forgets the plan for the current Tetromino; call this when the
+game the bot is playing is reset or swapped for another
+==================
+*/
+template <class BoardType>
+void Bot<BoardType>::Reset() {
+	m_pieceCount = -1;
+	m_targetRotation = 0;
+	m_targetX = 0;
+	m_planTicks = 0;
+}
+
+/*
+==================
+Decides what to press on the game's next tick - makes a plan when
+there is a new Tetromino, then rotates it and moves it towards the
+planned column, and hard drops it once it is there
+
+Parameters:
+>> game		The game being played
+
+Returns:
+>> Mask of INPUT_ bits to pass to Game::Tick
+==================
+*/
+template <class BoardType>
+uint32_t Bot<BoardType>::GetInput(Game<BoardType>* game) {
+	if (game->GetPieceCount() != m_pieceCount) {
+		Plan(game);
+	}
+
+	Tetromino* tet = game->GetTetromino();
+	uint32_t input = 0;
+
+	if (++m_planTicks > BOT_MAX_PLAN_TICKS) {
+		return INPUT_HARD_DROP;
+	}
+	if (tet->GetRotation() != m_targetRotation) {
+		int turns = (m_targetRotation - tet->GetRotation() + TET_ROTATION_COUNT) % TET_ROTATION_COUNT;
+		input |= (turns == TET_ROTATION_COUNT - 1) ? INPUT_ROTATE_ACW : INPUT_ROTATE_CW;
+	}
+	else if (tet->GetPivotXTile() < m_targetX) {
+		input |= INPUT_RIGHT;
+	}
+	else if (tet->GetPivotXTile() > m_targetX) {
+		input |= INPUT_LEFT;
+	}
+	else {
+		input |= INPUT_HARD_DROP;
+	}
+	return input;
+}
+
+/*
+==================
+Picks the rotation and column to drop the player Tetromino in, by
+scoring where it would land for every one of them. The columns it
+fits at in the spawn row come from the controller's batched
+collision test, and where it lands from the board's column masks
+
+Parameters:
+>> game		The game being played
+==================
+*/
+template <class BoardType>
+void Bot<BoardType>::Plan(Game<BoardType>* game) {
+	Tetromino* tet = game->GetTetromino();
+	BoardType* board = game->GetBoard();
+	uint64_t rows[BoardType::HEIGHT];
+	double bestScore = BOT_LOSING_SCORE;
+
+	// A copy of the Tetromino to try placements with, in rotation 0 to start
+	Tetromino probe;
+	TetrominoController<BoardType> controller(board, &probe);
+	probe = Tetromino(tet->GetShape(), tet->GetColor());
+
+	for (int i = 0; i < BoardType::HEIGHT; i++) {
+		rows[i] = board->GetRowMask(i);
+	}
+
+	m_pieceCount = game->GetPieceCount();
+	m_targetRotation = tet->GetRotation();
+	m_targetX = tet->GetPivotXTile();
+	m_planTicks = 0;
+
+	for (int rotation = 0; rotation < TET_ROTATION_COUNT; rotation++, probe.Rotate()) {
+		const TetrominoState& state = Tetromino::s_states.states[tet->GetShape()][rotation];
+		uint64_t columns = controller.GetValidColumns(rotation, TET_START_Y);
+		while (columns != 0) {
+			int xTile = CountTrailingZeros(columns) - state.minX;
+			columns &= columns - 1;
+
+			probe.SetPivotXTile(xTile);
+			probe.SetPivotYTile(TET_START_Y);
+			int yTile = TET_START_Y + controller.GetDropDistance();
+			double score = EvaluatePlacement(rows, tet->GetShape(), rotation, xTile, yTile);
+			if (score > bestScore) {
+				bestScore = score;
+				m_targetRotation = rotation;
+				m_targetX = xTile;
+			}
+		}
+	}
+}
+
+/*
+==================
+Places a shape where it lands on a copy of the board, clears any
+rows it fills, and scores the board that is left
+
+Parameters:
+>> rows			Row masks of the board, top to bottom
+>> shape		Shape to place
+>> rotation		Rotation state to place it in
+>> xTile		Horizontal tile for the pivot
+>> yTile		Vertical tile the pivot lands on
+
+Returns:
+>> The board's score; higher is better
+==================
+*/
+template <class BoardType>
+double Bot<BoardType>::EvaluatePlacement(uint64_t* rows, int shape, int rotation, int xTile, int yTile) {
+	const TetrominoState& state = Tetromino::s_states.states[shape][rotation];
+	constexpr int HEIGHT = BoardType::HEIGHT;
+	int shift = xTile + state.minX;
+
+	if (yTile + state.minY < 0) {
+		return BOT_LOSING_SCORE;
+	}
+
+	// Place it, and clear the rows it fills
+	uint64_t placed[HEIGHT];
+	for (int i = 0; i < HEIGHT; i++) {
+		placed[i] = rows[i];
+	}
+	for (int row = 0; row < state.rowCount; row++) {
+		placed[yTile + state.minY + row] |= (uint64_t)state.rowMasks[row] << shift;
+	}
+	int linesCleared = 0;
+	for (int i = HEIGHT - 1; i >= 0; i--) {
+		if (placed[i] == (uint64_t)BoardType::FULL_ROW_MASK) {
+			linesCleared++;
+		}
+		else if (linesCleared > 0) {
+			placed[i + linesCleared] = placed[i];
+		}
+	}
+	for (int i = 0; i < linesCleared; i++) {
+		placed[i] = 0;
+	}
+
+	// Column heights and holes, from one pass down the rows
+	int heights[BoardType::WIDTH] = {};
+	int holes = 0;
+	uint64_t covered = 0;
+	for (int i = 0; i < HEIGHT; i++) {
+		uint64_t tops = placed[i] & ~covered;
+		while (tops != 0) {
+			heights[CountTrailingZeros(tops)] = HEIGHT - i;
+			tops &= tops - 1;
+		}
+		uint64_t empty = covered & ~placed[i];
+		while (empty != 0) {
+			holes++;
+			empty &= empty - 1;
+		}
+		covered |= placed[i];
+	}
+
+	int totalHeight = 0;
+	int bumpiness = 0;
+	for (int x = 0; x < BoardType::WIDTH; x++) {
+		totalHeight += heights[x];
+		if (x > 0) {
+			bumpiness += (heights[x] > heights[x - 1]) ? heights[x] - heights[x - 1] : heights[x - 1] - heights[x];
+		}
+	}
+
+	return BOT_HEIGHT_WEIGHT * totalHeight + BOT_LINES_WEIGHT * linesCleared +
+		   BOT_HOLES_WEIGHT * holes + BOT_BUMPINESS_WEIGHT * bumpiness;
+}
+
+// ----- Board instantiations -----
+template class Bot<StandardBoard>;
+template class Bot<NarrowBoard>;
+template class Bot<TallBoard>;
+template class Bot<WideBoard>;
+// --------------------------------
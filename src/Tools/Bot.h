@@ -0,0 +1,46 @@
+/*****************************************************************************************
+/* File: Bot.h
+/* Description: A simple bot that plays a Game - for each new Tetromino it tries every
+/*				rotation and column, scores the board each would leave, and then presses
+/*				the inputs to get there
+/*
+/* Rachel Pearson 2022
+/*
+/*****************************************************************************************/
+
+// ------ Includes -----
+#include <stdint.h>
+#include "Board.h"
+#include "Game.h"
+// ---------------------
+
+// ------ Constants -----
+// Weights of the parts of a board's score; lower, flatter boards with fewer holes are better
+constexpr auto BOT_HEIGHT_WEIGHT = -0.510066;		// Per tile of total column height
+constexpr auto BOT_LINES_WEIGHT = 0.760666;			// Per row cleared
+constexpr auto BOT_HOLES_WEIGHT = -0.35663;			// Per empty tile with a filled tile above it
+constexpr auto BOT_BUMPINESS_WEIGHT = -0.184483;	// Per tile of height difference between neighbouring columns
+// ----------------------
+
+#pragma once
+
+// Works on any board size; it has no state besides its plan for the current
+// Tetromino, so one bot can play many games one after another as long as it is
+// reset between them
+template <class BoardType>
+class Bot
+{
+	public:
+		Bot();
+		void Reset();
+		uint32_t GetInput(Game<BoardType>* game);
+
+	private:
+		int m_pieceCount;			// Placements the game had when the plan was made, or -1 for no plan
+		int m_targetRotation;
+		int m_targetX;
+		int m_planTicks;			// Ticks spent on the current Tetromino
+
+		void Plan(Game<BoardType>* game);
+		double EvaluatePlacement(uint64_t* rows, int shape, int rotation, int xTile, int yTile);
+};
@@ -0,0 +1,303 @@
+/*****************************************************************************************
+/* File: DeterminismCheck.cpp
+/* Description: Checks that replays play out exactly the same as they did before - in
+/*				another build, with another compiler, or on several threads at once - by
+/*				comparing traces of the game state, and shows where they first differ
+/*
+/* Rachel Pearson 2022
+/*
+/*****************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Game.h"
+#include "Replay.h"
+#include "Determinism.h"
+
+/*
+==================
+Plays a replay from the start, tracing the game as it goes
+
+Parameters:
+>> replay		The replay, at its first tick
+>> interval		Ticks between checkpoints
+>> trace		The trace to record into
+==================
+*/
+template <class BoardType>
+static void TraceReplay(ReplayReader* replay, int interval, DeterminismTrace* trace) {
+	const ReplayHeader& header = replay->GetHeader();
+	Game<BoardType>* game = new Game<BoardType>(header.seed, header.randomizerType);
+	uint32_t input;
+
+	trace->Reset(interval, BoardType::WIDTH, BoardType::HEIGHT);
+	trace->Record(game);
+	while (replay->NextTick(&input)) {
+		game->Tick(input);
+		trace->Record(game);
+	}
+	delete game;
+}
+
+/*
+==================
+Plays a replay on a board of the size it was recorded on, tracing
+the game as it goes
+
+Returns:
+>> False if the board size isn't supported
+==================
+*/
+static bool TraceReplay(ReplayReader* replay, int interval, DeterminismTrace* trace) {
+	const ReplayHeader& header = replay->GetHeader();
+
+	if (header.boardWidth == StandardBoard::WIDTH && header.boardHeight == StandardBoard::HEIGHT) {
+		TraceReplay<StandardBoard>(replay, interval, trace);
+	}
+	else if (header.boardWidth == NarrowBoard::WIDTH && header.boardHeight == NarrowBoard::HEIGHT) {
+		TraceReplay<NarrowBoard>(replay, interval, trace);
+	}
+	else if (header.boardWidth == TallBoard::WIDTH && header.boardHeight == TallBoard::HEIGHT) {
+		TraceReplay<TallBoard>(replay, interval, trace);
+	}
+	else if (header.boardWidth == WideBoard::WIDTH && header.boardHeight == WideBoard::HEIGHT) {
+		TraceReplay<WideBoard>(replay, interval, trace);
+	}
+	else {
+		return false;
+	}
+	return true;
+}
+
+/*
+==================
+Checks that a replay or trace was recorded under these rules, and
+says so if not. One recorded under other rules is expected to play
+out differently, so it can't be checked, but that isn't a sign of
+anything having gone wrong
+
+Parameters:
+>> name		What was recorded, for the report
+>> version	RULESET_VERSION it was recorded with
+
+Returns:
+>> True if it was recorded under these rules
+==================
+*/
+static bool IsCurrentRuleset(const char* name, int version) {
+	if (version == RULESET_VERSION) {
+		return true;
+	}
+	printf("%s: OTHER RULESET - recorded with ruleset %d, but these rules are %d, so it can't be checked\n",
+		   name, version, RULESET_VERSION);
+	return false;
+}
+
+/*
+==================
+Compares two traces, and prints where and how they first differ
+
+Parameters:
+>> name			What is being compared, for the report
+>> expected		The trace that is known to be right
+>> actual		The trace being checked
+
+Returns:
+>> True if they agree
+==================
+*/
+static bool CompareTraces(const char* name, DeterminismTrace* expected, DeterminismTrace* actual) {
+	if (expected->GetInterval() != actual->GetInterval() ||
+		expected->GetBoardWidth() != actual->GetBoardWidth() || expected->GetBoardHeight() != actual->GetBoardHeight()) {
+		printf("%s: traces were recorded with different intervals or board sizes\n", name);
+		return false;
+	}
+	if (expected->GetRulesetVersion() != actual->GetRulesetVersion()) {
+		printf("%s: OTHER RULESET - traces were recorded with rulesets %d and %d, so they can't be compared\n",
+			   name, expected->GetRulesetVersion(), actual->GetRulesetVersion());
+		return false;
+	}
+
+	TraceDivergence divergence = expected->Compare(actual);
+	if (divergence.checkpoint < 0) {
+		printf("%s: same (%d checkpoints)\n", name, expected->GetCheckpointCount());
+		return true;
+	}
+
+	printf("%s: DIFFERENT - first at tick %u", name, divergence.tick);
+	if (divergence.checkpoint > 0) {
+		printf(", after agreeing up to tick %u", divergence.lastGoodTick);
+	}
+	printf("\n");
+	if (expected->GetInterval() > 1) {
+		printf("Record with an interval of 1 to find the exact tick\n");
+	}
+	expected->WriteBoardDiff(stdout, actual, divergence.checkpoint);
+	return false;
+}
+
+/*
+==================
+Records a trace of each replay, next to it
+
+Returns:
+>> Number of replays that couldn't be traced
+==================
+*/
+static int Record(char** paths, int count, int interval) {
+	int failures = 0;
+
+	for (int i = 0; i < count; i++) {
+		ReplayReader replay;
+		DeterminismTrace trace;
+		std::string tracePath = std::string(paths[i]) + TRACE_EXTENSION;
+		if (!replay.Open(paths[i])) {
+			printf("%s: could not read the replay\n", paths[i]);
+			failures++;
+			continue;
+		}
+		if (!IsCurrentRuleset(paths[i], replay.GetHeader().rulesetVersion)) {
+			failures++;
+			continue;
+		}
+		if (!TraceReplay(&replay, interval, &trace) || !trace.Save(tracePath.c_str())) {
+			printf("%s: could not trace\n", paths[i]);
+			failures++;
+			continue;
+		}
+		printf("%s: %d checkpoints\n", tracePath.c_str(), trace.GetCheckpointCount());
+	}
+	return failures;
+}
+
+/*
+==================
+Plays each replay, and checks it against the trace next to it
+
+Returns:
+>> Number of replays that didn't match
+==================
+*/
+static int Check(char** paths, int count) {
+	int failures = 0;
+
+	for (int i = 0; i < count; i++) {
+		ReplayReader replay;
+		DeterminismTrace expected;
+		DeterminismTrace actual;
+		std::string tracePath = std::string(paths[i]) + TRACE_EXTENSION;
+		if (!replay.Open(paths[i]) || !expected.Load(tracePath.c_str())) {
+			printf("%s: could not read the replay or its trace\n", paths[i]);
+			failures++;
+			continue;
+		}
+		if (!IsCurrentRuleset(paths[i], replay.GetHeader().rulesetVersion) ||
+			!IsCurrentRuleset(tracePath.c_str(), expected.GetRulesetVersion())) {
+			failures++;
+			continue;
+		}
+		if (!TraceReplay(&replay, expected.GetInterval(), &actual) || !CompareTraces(paths[i], &expected, &actual)) {
+			failures++;
+		}
+	}
+	return failures;
+}
+
+/*
+==================
+Plays each replay on this thread, then on several threads at once,
+and checks that every thread traced the same game
+
+Returns:
+>> Number of replays that didn't match
+==================
+*/
+static int CheckThreads(char** paths, int count, int threadCount, int interval) {
+	int failures = 0;
+
+	for (int i = 0; i < count; i++) {
+		ReplayReader replay;
+		DeterminismTrace expected;
+		if (!replay.Open(paths[i])) {
+			printf("%s: could not read the replay\n", paths[i]);
+			failures++;
+			continue;
+		}
+		if (!IsCurrentRuleset(paths[i], replay.GetHeader().rulesetVersion)) {
+			failures++;
+			continue;
+		}
+		if (!TraceReplay(&replay, interval, &expected)) {
+			printf("%s: could not trace\n", paths[i]);
+			failures++;
+			continue;
+		}
+
+		// Each thread plays its own copy of the replay
+		std::vector<ReplayReader> replays(threadCount);
+		std::vector<DeterminismTrace> traces(threadCount);
+		std::vector<std::thread> threads;
+		for (int j = 0; j < threadCount; j++) {
+			replays[j].OpenMemory(replay.GetData(), replay.GetSize());
+			threads.emplace_back([&replays, &traces, interval, j]() {
+				TraceReplay(&replays[j], interval, &traces[j]);
+			});
+		}
+		for (std::thread& thread : threads) {
+			thread.join();
+		}
+
+		bool same = true;
+		for (int j = 0; j < threadCount && same; j++) {
+			std::string name = std::string(paths[i]) + " thread " + std::to_string(j);
+			same = CompareTraces(name.c_str(), &expected, &traces[j]);
+		}
+		failures += same ? 0 : 1;
+	}
+	return failures;
+}
+
+/*
+==================
+Commands:
+	record [interval] <replay>...	Trace each replay to <replay>.trace
+	check <replay>...				Check each replay against its trace
+	compare <trace> <trace>			Compare two traces
+	threads <count> <replay>...		Check that threads all play each replay alike
+The exit code is the number of replays that failed
+==================
+*/
+int main(int argc, char* argv[]) {
+	if (argc >= 3 && strcmp(argv[1], "record") == 0) {
+		int interval = atoi(argv[2]);
+		if (interval > 0) {
+			return Record(&argv[3], argc - 3, interval);
+		}
+		return Record(&argv[2], argc - 2, DEFAULT_TRACE_INTERVAL);
+	}
+	if (argc >= 3 && strcmp(argv[1], "check") == 0) {
+		return Check(&argv[2], argc - 2);
+	}
+	if (argc == 4 && strcmp(argv[1], "compare") == 0) {
+		DeterminismTrace traces[2];
+		if (!traces[0].Load(argv[2]) || !traces[1].Load(argv[3])) {
+			printf("Could not read the traces\n");
+			return 1;
+		}
+		return CompareTraces("Traces", &traces[0], &traces[1]) ? 0 : 1;
+	}
+	if (argc >= 4 && strcmp(argv[1], "threads") == 0) {
+		return CheckThreads(&argv[3], argc - 3, atoi(argv[2]) > 0 ? atoi(argv[2]) : 1, 1);
+	}
+
+	printf("Usage:\n");
+	printf("  %s record [interval] <replay>...\n", argv[0]);
+	printf("  %s check <replay>...\n", argv[0]);
+	printf("  %s compare <trace> <trace>\n", argv[0]);
+	printf("  %s threads <count> <replay>...\n", argv[0]);
+	return 1;
+}
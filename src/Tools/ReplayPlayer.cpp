@@ -0,0 +1,90 @@
+/*****************************************************************************************
+/* File: ReplayPlayer.cpp
+/* Description: Plays a recorded replay again without a display, as fast as it can, and
+/*				prints how the game ended - for reproducing bug reports and checking that
+/*				a change to the code hasn't changed how games play out
+/*
+/* Rachel Pearson 2022
+/*
+/*****************************************************************************************/
+
+#include <stdio.h>
+#include <chrono>
+#include "Game.h"
+#include "Replay.h"
+
+/*
+==================
+Runs every tick of a replay on a new game and prints the result
+
+Parameters:
+>> replay	The loaded replay, at its first tick
+
+Returns:
+>> 0 on success
+==================
+*/
+template <class BoardType>
+static int PlayReplay(ReplayReader* replay) {
+	const ReplayHeader& header = replay->GetHeader();
+	Game<BoardType> game(header.seed, header.randomizerType);
+	uint32_t input;
+
+	auto start = std::chrono::steady_clock::now();
+	while (replay->NextTick(&input)) {
+		game.Tick(input);
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	printf("Ticks:  %u (%s)\n", game.GetTickCount(), game.IsGameOver() ? "game over" : "still playing");
+	printf("Score:  %d\n", game.GetScore());
+	printf("Pieces: %d\n", game.GetPieceCount());
+	printf("Hash:   %016llx\n", (unsigned long long)game.GetHash());
+	printf("Played in %.3f ms (%.0f ticks/s)\n", seconds * 1000.0, game.GetTickCount() / seconds);
+	return 0;
+}
+
+/*
+==================
+Loads the replay named by the first command line argument and
+plays it on a board of the size it was recorded on
+==================
+*/
+int main(int argc, char* argv[]) {
+	if (argc < 2) {
+		printf("Usage: %s <replay file>\n", argv[0]);
+		return 1;
+	}
+
+	ReplayReader replay;
+	if (!replay.Open(argv[1])) {
+		printf("Could not read replay %s\n", argv[1]);
+		return 1;
+	}
+
+	const ReplayHeader& header = replay.GetHeader();
+	printf("Seed %llu, %d x %d board, ruleset %d\n", (unsigned long long)header.seed,
+		   header.boardWidth, header.boardHeight, header.rulesetVersion);
+	if (header.rulesetVersion != RULESET_VERSION) {
+		printf("Warning: recorded with ruleset %d, but these rules are %d, so it may not play out the same\n",
+			   header.rulesetVersion, RULESET_VERSION);
+	}
+	if (!replay.IsComplete()) {
+		printf("Warning: the replay has no end record, so it is played up to its last input\n");
+	}
+
+	if (header.boardWidth == StandardBoard::WIDTH && header.boardHeight == StandardBoard::HEIGHT) {
+		return PlayReplay<StandardBoard>(&replay);
+	}
+	if (header.boardWidth == NarrowBoard::WIDTH && header.boardHeight == NarrowBoard::HEIGHT) {
+		return PlayReplay<NarrowBoard>(&replay);
+	}
+	if (header.boardWidth == TallBoard::WIDTH && header.boardHeight == TallBoard::HEIGHT) {
+		return PlayReplay<TallBoard>(&replay);
+	}
+	if (header.boardWidth == WideBoard::WIDTH && header.boardHeight == WideBoard::HEIGHT) {
+		return PlayReplay<WideBoard>(&replay);
+	}
+	printf("Unsupported board size\n");
+	return 1;
+}
@@ -0,0 +1,211 @@
+/*****************************************************************************************
+/* File: SimFarm.cpp
+/* Description: Plays a large number of headless games with the bot, spread over every
+/*				core. Each thread works through its own share of the games, and steals
+/*				half of another thread's remaining share when it runs out
+/*
+/* Rachel Pearson 2022
+/*
+/*****************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "Game.h"
+#include "Bot.h"
+
+// ------ Constants -----
+constexpr auto DEFAULT_GAME_COUNT = 10000;
+constexpr auto DEFAULT_MAX_PIECES = 500;		// Games are stopped after this many placements
+constexpr auto MAX_THREADS = 256;
+constexpr auto CACHE_LINE_SIZE = 64;
+// ----------------------
+
+// The games a thread has left to play, [begin, end), packed into one value so that
+// both ends can be changed together with a compare-and-swap. The owner takes games
+// from the front and thieves take them from the back. Each is on its own cache line,
+// so threads taking their own games don't slow each other down
+struct alignas(CACHE_LINE_SIZE) WorkRange {
+	std::atomic<uint64_t> range;
+};
+
+// Totals for one thread, kept on the thread's own stack while it runs and merged
+// once every thread has finished
+struct alignas(CACHE_LINE_SIZE) FarmStats {
+	long long games;
+	long long pieces;
+	long long ticks;
+	long long score;
+	int steals;
+	double seconds;
+};
+
+static WorkRange s_work[MAX_THREADS];
+
+static uint64_t PackRange(uint32_t begin, uint32_t end) {
+	return ((uint64_t)end << 32) | begin;
+}
+
+/*
+==================
+Takes the next game from the front of a thread's own range
+
+Parameters:
+>> work		The thread's range
+
+Returns:
+>> The game's number, or -1 if the range is empty
+==================
+*/
+static int TakeGame(WorkRange* work) {
+	uint64_t range = work->range.load(std::memory_order_relaxed);
+
+	for (;;) {
+		uint32_t begin = (uint32_t)range;
+		uint32_t end = (uint32_t)(range >> 32);
+		if (begin >= end) {
+			return -1;
+		}
+		if (work->range.compare_exchange_weak(range, PackRange(begin + 1, end), std::memory_order_relaxed)) {
+			return (int)begin;
+		}
+	}
+}
+
+/*
+==================
+Steals half of the games another thread has left, from the back of
+its range, and makes them the thief's range. Only called once the
+thief's own range is empty, so no other thread can take from it in
+the meantime
+
+Parameters:
+>> thread		The thief's number
+>> threadCount	Number of threads
+
+Returns:
+>> True if any games were stolen
+==================
+*/
+static bool StealGames(int thread, int threadCount) {
+	for (int i = 1; i < threadCount; i++) {
+		WorkRange* victim = &s_work[(thread + i) % threadCount];
+		uint64_t range = victim->range.load(std::memory_order_relaxed);
+
+		for (;;) {
+			uint32_t begin = (uint32_t)range;
+			uint32_t end = (uint32_t)(range >> 32);
+			if (begin >= end) {
+				break;
+			}
+			uint32_t middle = end - (end - begin + 1) / 2;
+			if (victim->range.compare_exchange_weak(range, PackRange(begin, middle), std::memory_order_relaxed)) {
+				s_work[thread].range.store(PackRange(middle, end), std::memory_order_relaxed);
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+/*
+==================
+Plays games until there are none left to take or steal. Game n is
+seeded with n, so the results don't depend on which thread plays it
+
+Parameters:
+>> thread		The thread's number
+>> threadCount	Number of threads
+>> maxPieces	Placements after which a game is stopped
+>> result		Where the thread's totals are written when it
+				finishes
+==================
+*/
+static void RunWorker(int thread, int threadCount, int maxPieces, FarmStats* result) {
+	FarmStats stats = {};
+	Game<StandardBoard> game(0, RANDOMIZER_BAG);
+	Bot<StandardBoard> bot;
+	auto start = std::chrono::steady_clock::now();
+
+	for (;;) {
+		int gameNumber = TakeGame(&s_work[thread]);
+		if (gameNumber < 0) {
+			if (!StealGames(thread, threadCount)) {
+				break;
+			}
+			stats.steals++;
+			continue;
+		}
+
+		game.Reset((uint64_t)gameNumber);
+		bot.Reset();
+		while (game.GetPieceCount() < maxPieces && game.Tick(bot.GetInput(&game))) {
+			stats.ticks++;
+		}
+		stats.games++;
+		stats.pieces += game.GetPieceCount();
+		stats.score += game.GetScore();
+	}
+
+	stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	*result = stats;
+}
+
+/*
+==================
+Splits the games evenly between the threads, runs them, and prints
+each thread's throughput and the totals. Arguments are the number
+of games, the number of threads and the most placements per game
+==================
+*/
+int main(int argc, char* argv[]) {
+	int gameCount = (argc > 1) ? atoi(argv[1]) : DEFAULT_GAME_COUNT;
+	int threadCount = (argc > 2) ? atoi(argv[2]) : (int)std::thread::hardware_concurrency();
+	int maxPieces = (argc > 3) ? atoi(argv[3]) : DEFAULT_MAX_PIECES;
+	if (gameCount < 1 || maxPieces < 1) {
+		printf("Usage: %s [games >= 1] [threads] [pieces per game >= 1]\n", argv[0]);
+		return 1;
+	}
+
+	// hardware_concurrency() may be 0 if it can't tell
+	threadCount = (threadCount < 1) ? 1 : (threadCount > MAX_THREADS) ? MAX_THREADS : threadCount;
+	for (int i = 0; i < threadCount; i++) {
+		uint32_t begin = (uint32_t)((long long)gameCount * i / threadCount);
+		uint32_t end = (uint32_t)((long long)gameCount * (i + 1) / threadCount);
+		s_work[i].range.store(PackRange(begin, end));
+	}
+
+	std::vector<FarmStats> results(threadCount);
+	std::vector<std::thread> threads;
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < threadCount; i++) {
+		threads.emplace_back(RunWorker, i, threadCount, maxPieces, &results[i]);
+	}
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	FarmStats total = {};
+	printf("%d games, %d threads, up to %d pieces each\n", gameCount, threadCount, maxPieces);
+	printf("Thread     Games     Pieces  Steals      Games/s     Pieces/s\n");
+	for (int i = 0; i < threadCount; i++) {
+		const FarmStats& stats = results[i];
+		printf("%6d %9lld %10lld %7d %12.1f %12.0f\n", i, stats.games, stats.pieces, stats.steals,
+			   stats.games / stats.seconds, stats.pieces / stats.seconds);
+		total.games += stats.games;
+		total.pieces += stats.pieces;
+		total.ticks += stats.ticks;
+		total.score += stats.score;
+	}
+	printf(" Total %9lld %10lld %7s %12.1f %12.0f\n", total.games, total.pieces, "",
+		   total.games / seconds, total.pieces / seconds);
+	printf("Mean score %.1f, mean pieces %.1f, %.0f ticks/s\n",
+		   (double)total.score / total.games, (double)total.pieces / total.games, total.ticks / seconds);
+
+	return 0;
+}
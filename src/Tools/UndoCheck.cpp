@@ -0,0 +1,142 @@
+/*****************************************************************************************
+/* File: UndoCheck.cpp
+/* Description: Plays games with the bot on every board size with an UndoStack attached,
+/*				and checks that undoing a placement puts back the exact state of the game
+/*				from the start of the tick it was made on
+/*
+/* Rachel Pearson 2022
+/*
+/*****************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <vector>
+#include "Bot.h"
+
+// ------ Constants -----
+constexpr auto DEFAULT_PLACEMENTS = 20000;
+constexpr auto SMALL_UNDO_STACK_SIZE = 3;		// Small enough that old entries are dropped all the time
+constexpr auto TAKE_BACK_INTERVAL = 37;			// Placements between taking back several at once
+// ----------------------
+
+/*
+==================
+Plays games until a number of placements have been made. Each
+placement is undone straight away and made again, checking the
+state hash after both, and now and then several placements are
+taken back at once, checking each against the hash from the start
+of the tick it was made on
+
+Parameters:
+>> seed			Seed for the first game; each game after uses the next
+>> capacity		Size of the undo stack
+>> placements	Placements to make
+
+Returns:
+>> The number of undos or redos that didn't give the expected state
+==================
+*/
+template <class BoardType>
+static int CheckUndo(uint64_t seed, int capacity, int placements) {
+	Game<BoardType> game(seed, RANDOMIZER_BAG);
+	UndoStack<BoardType> undoStack(capacity);
+	Bot<BoardType> bot;
+	std::vector<uint64_t> hashes;		// State hash from before each placement on the stack, oldest first
+	int placed = 0;
+	int undone = 0;
+	int failures = 0;
+
+	game.SetUndoStack(&undoStack);
+	while (placed < placements) {
+		if (game.IsGameOver()) {
+			game.Reset(++seed);
+			bot.Reset();
+			hashes.clear();
+		}
+
+		uint64_t before = game.GetStateHash();
+		int pieceCount = game.GetPieceCount();
+		uint32_t input = bot.GetInput(&game);
+		game.Tick(input);
+		if (game.GetPieceCount() == pieceCount && !game.IsGameOver()) {
+			continue;
+		}
+
+		// Undo the placement, then make it again with the same input
+		uint64_t after = game.GetStateHash();
+		if (!game.UndoPlacement() || game.GetStateHash() != before) {
+			if (failures++ == 0) {
+				printf("%dx%d: placement %d: state hash %016llx after undoing it, expected %016llx\n",
+					   BoardType::WIDTH, BoardType::HEIGHT, placed,
+					   (unsigned long long)game.GetStateHash(), (unsigned long long)before);
+			}
+		}
+		game.Tick(input);
+		if (game.GetStateHash() != after) {
+			if (failures++ == 0) {
+				printf("%dx%d: placement %d: state hash %016llx after making it again, expected %016llx\n",
+					   BoardType::WIDTH, BoardType::HEIGHT, placed,
+					   (unsigned long long)game.GetStateHash(), (unsigned long long)after);
+			}
+		}
+		placed++;
+
+		hashes.push_back(before);
+		if ((int)hashes.size() > capacity) {
+			hashes.erase(hashes.begin());
+		}
+		if ((int)hashes.size() != game.GetUndoCount()) {
+			if (failures++ == 0) {
+				printf("%dx%d: placement %d: %d placements can be undone, expected %d\n",
+					   BoardType::WIDTH, BoardType::HEIGHT, placed, game.GetUndoCount(), (int)hashes.size());
+			}
+		}
+
+		// Take back several placements in a row
+		if (placed % TAKE_BACK_INTERVAL == 0) {
+			int count = 1 + (placed / TAKE_BACK_INTERVAL) % capacity;
+			while (count-- > 0 && !hashes.empty()) {
+				if (!game.UndoPlacement() || game.GetStateHash() != hashes.back()) {
+					if (failures++ == 0) {
+						printf("%dx%d: placement %d: state hash %016llx after taking it back, expected %016llx\n",
+							   BoardType::WIDTH, BoardType::HEIGHT, placed,
+							   (unsigned long long)game.GetStateHash(), (unsigned long long)hashes.back());
+					}
+				}
+				hashes.pop_back();
+				undone++;
+			}
+		}
+	}
+
+	printf("%3d x %-3d undo stack of %-3d %8d placements, %7d taken back: %s\n", BoardType::WIDTH,
+		   BoardType::HEIGHT, capacity, placed, undone, (failures == 0) ? "ok" : "FAILED");
+	return failures;
+}
+
+/*
+==================
+Checks undo on every board size, with the default undo stack and
+with a small one, making the number of placements given by the
+first command line argument in each. Fails if any check fails
+==================
+*/
+int main(int argc, char* argv[]) {
+	int placements = (argc > 1) ? atoi(argv[1]) : DEFAULT_PLACEMENTS;
+	int failures = 0;
+
+	for (int capacity : { (int)UNDO_STACK_SIZE, (int)SMALL_UNDO_STACK_SIZE }) {
+		failures += CheckUndo<StandardBoard>(1, capacity, placements);
+		failures += CheckUndo<NarrowBoard>(2, capacity, placements);
+		failures += CheckUndo<TallBoard>(3, capacity, placements);
+		failures += CheckUndo<WideBoard>(4, capacity, placements);
+	}
+
+	if (failures != 0) {
+		printf("%d undo checks failed\n", failures);
+		return 1;
+	}
+	printf("Every undo put back the state it was meant to\n");
+	return 0;
+}